@@ -0,0 +1,68 @@
+#include "barcode.h"
+
+// GS1 校验位：从校验位左边一位开始向左，权重依次为 3,1,3,1...
+static uint8_t Barcode_Check_Digit_OK(const char *code, uint8_t len)
+{
+    uint16_t sum = 0;
+    uint8_t weight = 3;
+    int8_t i;
+
+    for (i = (int8_t)len - 2; i >= 0; i--)
+    {
+        sum += (uint16_t)(code[i] - '0') * weight;
+        weight ^= 2; // 3 <-> 1
+    }
+    return (uint8_t)((10 - sum % 10) % 10) == (uint8_t)(code[len - 1] - '0');
+}
+
+Barcode_Result_t Barcode_Validate(const char *code, uint8_t len)
+{
+    uint8_t i;
+
+    if (len == 0)
+    {
+        return BARCODE_BAD_FORMAT;
+    }
+    for (i = 0; i < len; i++)
+    {
+        if (code[i] < '0' || code[i] > '9')
+        {
+            return BARCODE_BAD_FORMAT;
+        }
+    }
+
+#if BARCODE_CHECK_ENABLE
+    if (len <= BARCODE_PLU_MAX_DIGITS)
+    {
+        return BARCODE_PLU;
+    }
+    if (len != 8 && len != 12 && len != 13)
+    {
+        return BARCODE_BAD_LENGTH;
+    }
+    if (len == 13 && code[0] == '9' && (code[1] == '8' || code[1] == '9'))
+    {
+        return BARCODE_BAD_PREFIX;
+    }
+    if (!Barcode_Check_Digit_OK(code, len))
+    {
+        return BARCODE_BAD_CHECK;
+    }
+#endif
+    return BARCODE_OK;
+}
+
+const char *Barcode_Alarm_Msg(Barcode_Result_t result)
+{
+    switch (result)
+    {
+    case BARCODE_BAD_LENGTH:
+        return "Bad_Barcode_Length";
+    case BARCODE_BAD_PREFIX:
+        return "Bad_Barcode_Prefix";
+    case BARCODE_BAD_CHECK:
+        return "Bad_Check_Digit";
+    default:
+        return "Invalid_ID";
+    }
+}
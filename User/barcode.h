@@ -0,0 +1,27 @@
+#ifndef __BARCODE_H
+#define __BARCODE_H
+
+#include "stm32f10x.h"
+
+// ==========================================
+// 扫码条码校验 (EAN-8 / UPC-A / EAN-13)
+// ==========================================
+// 误读的条码能通过数字解析却不可能存在，提前在解析阶段拒绝，免得每次都把整个 Flash 库遍历一遍
+#define BARCODE_CHECK_ENABLE    1   // 0=关闭校验 (全部视为有效)
+#define BARCODE_PLU_MAX_DIGITS  5   // 不超过该位数的纯数字视为店内 PLU 码，跳过校验 (0=不允许 PLU)
+
+typedef enum {
+    BARCODE_OK = 0,         // 校验通过
+    BARCODE_PLU,            // 店内 PLU 短码，未校验
+    BARCODE_BAD_FORMAT,     // 空或含非数字字符
+    BARCODE_BAD_LENGTH,     // 长度不是 8/12/13 位
+    BARCODE_BAD_PREFIX,     // 非商品前缀 (EAN-13 98x/99x 为优惠券/退款单)
+    BARCODE_BAD_CHECK       // 校验位错误
+} Barcode_Result_t;
+
+// 校验 code 的前 len 个字符 (不要求 '\0' 结尾)
+Barcode_Result_t Barcode_Validate(const char *code, uint8_t len);
+// 校验失败时 ALARM 的 MSG 字段
+const char *Barcode_Alarm_Msg(Barcode_Result_t result);
+
+#endif
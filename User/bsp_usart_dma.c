@@ -1,7 +1,39 @@
 
 #include "bsp_usart_dma.h"
+#include <string.h>
 
-uint8_t ReceiveBuff[RECEIVEBUFF_SIZE];
+// 当前生效的波特率
+static uint32_t g_usart_baudrate = DEBUG_USART_BAUDRATE;
+static const uint32_t g_usart_baudrate_list[] = DEBUG_USART_BAUDRATE_LIST;
+
+static void USART_Apply_Params(uint32_t baudrate);
+
+// 发送环形缓冲区 (每个逻辑通道一个)：head 由写入方推进，tail 在 DMA 传输完成中断中推进
+// commit 之前的数据才允许发送：协议帧整帧写入后提交，日志只提交到最后一个完整行
+typedef struct
+{
+	uint8_t *buf;
+	uint16_t size;                  // 必须是 2 的幂
+	volatile uint16_t head;
+	volatile uint16_t commit;
+	volatile uint16_t tail;
+	volatile uint32_t dropped;      // 因缓冲区满丢弃的字节数
+} USART_TX_Ring_t;
+
+static uint8_t g_tx_buf_proto[USART_TX_PROTO_RING_SIZE];
+static uint8_t g_tx_buf_log[USART_TX_LOG_RING_SIZE];
+static USART_TX_Ring_t g_tx_ring[USART_TX_CH_COUNT] =
+{
+	{g_tx_buf_proto, USART_TX_PROTO_RING_SIZE, 0, 0, 0, 0},
+	{g_tx_buf_log,   USART_TX_LOG_RING_SIZE,   0, 0, 0, 0},
+};
+static volatile uint16_t g_tx_dma_len = 0;      // 正在传输的字节数，0=DMA 空闲
+static volatile uint8_t g_tx_dma_ch = 0;        // 正在传输的通道
+static uint8_t g_tx_log_mid_line = 0;           // 上一段日志停在行中间，下一段必须继续发日志
+static uint8_t g_tx_policy = USART_TX_POLICY_DEFAULT;
+
+static void USART_TX_DMA_Config(void);
+static void USART_TX_Kick(void);
 
 /**
   * @brief  USART GPIO 配置,工作参数配置
@@ -11,7 +43,6 @@ uint8_t ReceiveBuff[RECEIVEBUFF_SIZE];
 void USART_Config(void)
 {
 	GPIO_InitTypeDef GPIO_InitStructure;
-	USART_InitTypeDef USART_InitStructure;
     NVIC_InitTypeDef NVIC_InitStruct;
 	// 打开串口GPIO的时钟
 	DEBUG_USART_GPIO_APBxClkCmd(DEBUG_USART_GPIO_CLK, ENABLE);
@@ -38,8 +69,268 @@ void USART_Config(void)
 	GPIO_Init(DEBUG_USART_RX_GPIO_PORT, &GPIO_InitStructure);
 	
 	// 配置串口的工作参数
+	USART_Apply_Params(DEBUG_USART_BAUDRATE);
+	//使能空闲中断
+	USART_ITConfig(DEBUG_USARTx,USART_IT_IDLE,ENABLE);
+	// 发送走 DMA
+	USART_TX_DMA_Config();
+	// 使能串口
+	USART_Cmd(DEBUG_USARTx, ENABLE);	    
+}
+
+/**
+  * @brief  USART1 TX DMA 配置 (内存 -> USART1->DR)，每段传输完成后在中断中接续下一段
+  */
+static void USART_TX_DMA_Config(void)
+{
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStruct;
+
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	DMA_DeInit(USART_TX_DMA_CHANNEL);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = USART_DR_ADDRESS;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)g_tx_buf_proto;  // 每次启动前重新设置
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Low;  // 低于 SPI Flash 的 DMA
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(USART_TX_DMA_CHANNEL, &DMA_InitStructure);
+	DMA_ITConfig(USART_TX_DMA_CHANNEL, DMA_IT_TC, ENABLE);
+
+	NVIC_InitStruct.NVIC_IRQChannel = USART_TX_DMA_IRQ;
+	NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 1;
+	NVIC_InitStruct.NVIC_IRQChannelSubPriority = 2;
+	NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_InitStruct);
+
+	USART_DMACmd(DEBUG_USARTx, USART_DMAReq_Tx, ENABLE);
+}
+
+/**
+  * @brief  DMA 空闲时选择通道并启动一段连续内存的传输
+  * @note   协议通道优先；日志每段最多 USART_TX_LOG_CHUNK 字节，且只在行尾让出，
+  *         所以协议帧最多等一行日志，也不会插进日志行中间
+  *         调用方需已关中断或处于 DMA 中断中
+  */
+static void USART_TX_Kick(void)
+{
+	USART_TX_Ring_t *r;
+	uint16_t len;
+	uint8_t ch, log_ready;
+
+	if (g_tx_dma_len != 0)
+	{
+		return;
+	}
+	log_ready = (g_tx_ring[USART_TX_CH_LOG].commit != g_tx_ring[USART_TX_CH_LOG].tail);
+	if (g_tx_log_mid_line && log_ready)
+	{
+		ch = USART_TX_CH_LOG;
+	}
+	else if (g_tx_ring[USART_TX_CH_PROTO].commit != g_tx_ring[USART_TX_CH_PROTO].tail)
+	{
+		ch = USART_TX_CH_PROTO;
+	}
+	else if (log_ready)
+	{
+		ch = USART_TX_CH_LOG;
+	}
+	else
+	{
+		return;
+	}
+
+	r = &g_tx_ring[ch];
+	len = (r->commit > r->tail) ? (r->commit - r->tail) : (r->size - r->tail);
+	if (ch == USART_TX_CH_LOG)
+	{
+		if (len > USART_TX_LOG_CHUNK)
+		{
+			len = USART_TX_LOG_CHUNK;
+		}
+		g_tx_log_mid_line = (r->buf[(r->tail + len - 1) & (r->size - 1)] != '\n');
+	}
+	g_tx_dma_ch = ch;
+	g_tx_dma_len = len;
+
+	USART_TX_DMA_CHANNEL->CMAR = (uint32_t)&r->buf[r->tail];
+	DMA_SetCurrDataCounter(USART_TX_DMA_CHANNEL, len);
+	DMA_Cmd(USART_TX_DMA_CHANNEL, ENABLE);
+}
+
+/**
+  * @brief  写入发送缓冲区，USART_TX_Write / USART_TX_Write_Record 共用
+  * @param  whole: 1 = 整条写入，空间不足时等待或整条丢弃；0 = 按字节写入，能放多少放多少
+  * @retval 实际写入的字节数
+  */
+static uint16_t USART_TX_Write_Ex(uint8_t channel, const uint8_t *data, uint16_t len, uint8_t whole)
+{
+	USART_TX_Ring_t *r = &g_tx_ring[channel];
+	uint16_t mask = r->size - 1;
+	uint16_t written = 0;
+
+	// 整条记录比整个缓冲区还长，永远放不下
+	if (whole && len > mask)
+	{
+		r->dropped += len;
+		return 0;
+	}
+
+	while (written < len)
+	{
+		uint32_t primask = __get_PRIMASK();
+		uint16_t space, n, first, i;
+
+		__disable_irq();
+		space = mask - ((r->head - r->tail) & mask);
+		n = len - written;
+		if (n > space)
+		{
+			n = whole ? 0 : space;
+		}
+		// 分两段拷贝处理回绕
+		first = r->size - r->head;
+		if (first > n)
+		{
+			first = n;
+		}
+		memcpy(&r->buf[r->head], data + written, first);
+		memcpy(r->buf, data + written + first, n - first);
+		r->head = (r->head + n) & mask;
+		if (channel == USART_TX_CH_PROTO)
+		{
+			r->commit = r->head;
+		}
+		else
+		{
+			// 提交到本次写入的最后一个换行之后
+			for (i = n; i > 0; i--)
+			{
+				if (data[written + i - 1] == '\n')
+				{
+					r->commit = (r->head - (n - i)) & mask;
+					break;
+				}
+			}
+		}
+		written += n;
+		USART_TX_Kick();
+		__set_PRIMASK(primask);
+
+		if (written < len)
+		{
+			// 中断里 (如 TIM2 中的日志) 或关中断时等待会死锁，只能丢弃
+			if ((channel == USART_TX_CH_LOG && g_tx_policy == USART_TX_POLICY_DROP) || primask != 0 ||
+			    (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0)
+			{
+				r->dropped += len - written;
+				break;
+			}
+			// 等待 DMA 完成中断腾出空间 (整条写入要等到整条放得下)
+			while ((uint16_t)(mask - ((r->head - r->tail) & mask)) < (whole ? len : 1))
+			{
+				// 已提交的发完后缓冲区仍被没有换行的文本占着，只能强制提交
+				__disable_irq();
+				if (r->commit == r->tail && r->head != r->tail)
+				{
+					r->commit = r->head;
+					USART_TX_Kick();
+				}
+				__set_PRIMASK(primask);
+			}
+		}
+	}
+	return written;
+}
+
+/**
+  * @brief  写入指定通道的发送缓冲区，立即返回，由 DMA 在后台发出
+  * @param  channel: USART_TX_CH_PROTO 整帧写入，空间不足时等待或整帧丢弃，不会只发半帧
+  *                  USART_TX_CH_LOG   按字节写入，遇到 '\n' 才提交发送；满时按 USART_TX_Set_Policy 处理
+  * @retval 实际写入的字节数
+  */
+uint16_t USART_TX_Write(uint8_t channel, const uint8_t *data, uint16_t len)
+{
+	return USART_TX_Write_Ex(channel, data, len, channel == USART_TX_CH_PROTO);
+}
+
+/**
+  * @brief  把一条完整记录 (一行日志或一帧二进制日志) 整条写入发送缓冲区
+  * @note   放不下时按 USART_TX_Set_Policy 等待或整条丢弃并计入 dropped，
+  *         不会像 USART_TX_Write 那样只写进前半条，TIM2 中的日志也不会插进半行文本里
+  * @retval len = 已写入，0 = 已丢弃
+  */
+uint16_t USART_TX_Write_Record(uint8_t channel, const uint8_t *data, uint16_t len)
+{
+	return USART_TX_Write_Ex(channel, data, len, 1);
+}
+
+/**
+  * @brief  等待发送缓冲区中的数据全部移出串口 (切换波特率等场合使用)
+  * @note   没有换行结尾的日志也一并提交发出
+  */
+void USART_TX_Flush(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t ch;
+
+	__disable_irq();
+	g_tx_ring[USART_TX_CH_LOG].commit = g_tx_ring[USART_TX_CH_LOG].head;
+	USART_TX_Kick();
+	__set_PRIMASK(primask);
+
+	for (ch = 0; ch < USART_TX_CH_COUNT; ch++)
+	{
+		while (g_tx_ring[ch].head != g_tx_ring[ch].tail);
+	}
+	while (g_tx_dma_len != 0);
+	while (USART_GetFlagStatus(DEBUG_USARTx, USART_FLAG_TC) == RESET);
+}
+
+void USART_TX_Set_Policy(uint8_t policy)
+{
+	g_tx_policy = policy;
+}
+
+uint32_t USART_TX_Get_Dropped(uint8_t channel)
+{
+	return g_tx_ring[channel].dropped;
+}
+
+/**
+  * @brief  DMA1 通道 4 传输完成：释放已发送的数据并接续下一段
+  */
+void USART_TX_DMA_IRQ_Handler(void)
+{
+	if (DMA_GetITStatus(USART_TX_DMA_IT_TC) != RESET)
+	{
+		USART_TX_Ring_t *r = &g_tx_ring[g_tx_dma_ch];
+
+		DMA_ClearITPendingBit(USART_TX_DMA_IT_TC);
+		DMA_Cmd(USART_TX_DMA_CHANNEL, DISABLE);
+
+		r->tail = (r->tail + g_tx_dma_len) & (r->size - 1);
+		g_tx_dma_len = 0;
+		USART_TX_Kick();
+	}
+}
+
+/**
+  * @brief  配置串口工作参数 (8N1，无流控，收发一起)
+  * @note   USART_Init 只改写 BRR 与帧格式位，不影响已使能的中断
+  */
+static void USART_Apply_Params(uint32_t baudrate)
+{
+	USART_InitTypeDef USART_InitStructure;
+
 	// 配置波特率
-	USART_InitStructure.USART_BaudRate = DEBUG_USART_BAUDRATE;
+	USART_InitStructure.USART_BaudRate = baudrate;
 	// 配置 针数据字长
 	USART_InitStructure.USART_WordLength = USART_WordLength_8b;
 	// 配置停止位
@@ -51,13 +342,65 @@ void USART_Config(void)
 	// 配置工作模式，收发一起
 	USART_InitStructure.USART_Mode = USART_Mode_Rx | USART_Mode_Tx;
 	// 完成串口的初始化配置
-	USART_Init(DEBUG_USARTx, &USART_InitStructure);	
-	//使能空闲中断
-	USART_ITConfig(DEBUG_USARTx,USART_IT_IDLE,ENABLE);
-	// 使能串口
-	USART_Cmd(DEBUG_USARTx, ENABLE);	    
+	USART_Init(DEBUG_USARTx, &USART_InitStructure);
+	g_usart_baudrate = baudrate;
 }
 
+/**
+  * @brief  运行中切换波特率
+  * @note   先等待发送缓冲区清空且 TC 置位，保证切换前的应答以旧波特率完整发出
+  */
+void USART_Set_Baudrate(uint32_t baudrate)
+{
+	USART_TX_Flush();
+
+	USART_Cmd(DEBUG_USARTx, DISABLE);
+	USART_Apply_Params(baudrate);
+	USART_Cmd(DEBUG_USARTx, ENABLE);
+}
+
+uint32_t USART_Get_Baudrate(void)
+{
+	return g_usart_baudrate;
+}
+
+/**
+  * @brief  判断是否为允许协商的波特率
+  * @retval 1=支持, 0=不支持
+  */
+uint8_t USART_Is_Baudrate_Supported(uint32_t baudrate)
+{
+	uint8_t i;
+
+	for (i = 0; i < sizeof(g_usart_baudrate_list) / sizeof(g_usart_baudrate_list[0]); i++)
+	{
+		if (g_usart_baudrate_list[i] == baudrate)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+  * @brief  接收中断中累加 ORE/FE/NE 计数，须在读 DR 之前调用 (读 SR 再读 DR 即清除错误标志)
+  * @param  sr: 进入中断时读到的状态寄存器
+  */
+void USART_Rx_Count_Errors(uint16_t sr, USART_Rx_Errors_t *err)
+{
+	if (sr & USART_FLAG_ORE)
+	{
+		err->overrun++;
+	}
+	if (sr & USART_FLAG_FE)
+	{
+		err->framing++;
+	}
+	if (sr & USART_FLAG_NE)
+	{
+		err->noise++;
+	}
+}
 
 /*****************  发送一个字节 **********************/
 void Usart_SendByte( USART_TypeDef * pUSARTx, uint8_t ch)
@@ -121,11 +464,10 @@ void Usart_SendHalfWord( USART_TypeDef * pUSARTx, uint16_t ch)
 ///重定向c库函数printf到串口，重定向后可使用printf函数
 int fputc(int ch, FILE *f)
 {
-		/* 发送一个字节数据到串口 */
-		USART_SendData(DEBUG_USARTx, (uint8_t) ch);
-		
-		/* 等待发送完毕 */
-		while (USART_GetFlagStatus(DEBUG_USARTx, USART_FLAG_TXE) == RESET);		
+		uint8_t byte = (uint8_t) ch;
+
+		/* printf 输出走日志通道，由 DMA 发送，不再逐字节等待 TXE */
+		USART_TX_Write(USART_TX_CH_LOG, &byte, 1);
 	
 		return (ch);
 }
@@ -139,45 +481,3 @@ int fgetc(FILE *f)
 		return (int)USART_ReceiveData(DEBUG_USARTx);
 }
 
-/**
-  * @brief  USARTx TX DMA 配置，内存到外设(USART1->DR)
-  * @param  无
-  * @retval 无
-  */
-void USARTx_DMA_Config(void)
-{
-		DMA_InitTypeDef DMA_InitStructure;
-		// 开启DMA时钟
-		RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
-	    
-		// 设置DMA源地址：串口数据寄存器地址*/
-        DMA_InitStructure.DMA_PeripheralBaseAddr = USART_DR_ADDRESS;
-		// 内存地址(要传输的变量的指针)
-		DMA_InitStructure.DMA_MemoryBaseAddr = (u32)ReceiveBuff;
-		// 方向：从外设到内存	
-		DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
-		// 传输大小	
-		DMA_InitStructure.DMA_BufferSize = RECEIVEBUFF_SIZE;
-		// 外设地址不增	    
-		DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
-		// 内存地址自增
-		DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
-		// 外设数据单位	
-		DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
-		// 内存数据单位
-		DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;	 
-		// DMA模式，一次或者循环模式
-//		DMA_InitStructure.DMA_Mode = DMA_Mode_Normal ;
-		DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;	
-		// 优先级：中	
-		DMA_InitStructure.DMA_Priority = DMA_Priority_Medium; 
-		// 禁止内存到内存的传输
-		DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
-		// 配置DMA通道		   
-		DMA_Init(USART_TX_DMA_CHANNEL, &DMA_InitStructure);		
-		// 使能DMA
-		DMA_Cmd (USART_TX_DMA_CHANNEL,ENABLE);
-}
-
-
-
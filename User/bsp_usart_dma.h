@@ -10,7 +10,9 @@
 #define  DEBUG_USARTx                   USART1
 #define  DEBUG_USART_CLK                RCC_APB2Periph_USART1
 #define  DEBUG_USART_APBxClkCmd         RCC_APB2PeriphClockCmd
-#define  DEBUG_USART_BAUDRATE           115200
+#define  DEBUG_USART_BAUDRATE           115200   // 上电默认波特率，协商失败时回退到协商前的值
+// CMD:SET_BAUD 允许协商的波特率 (USART1 在 APB2 72MHz 上，最高可到 4.5Mbps)
+#define  DEBUG_USART_BAUDRATE_LIST      {115200, 460800, 921600, 2000000}
 
 // USART GPIO 引脚宏定义
 #define  DEBUG_USART_GPIO_CLK           (RCC_APB2Periph_GPIOA)
@@ -24,14 +26,53 @@
 #define  DEBUG_USART_IRQ                USART1_IRQn
 #define  DEBUG_USART_IRQHandler         USART1_IRQHandler
 
-// 串口对应的DMA请求通道
-#define  USART_TX_DMA_CHANNEL     DMA1_Channel5
+// 串口对应的DMA请求通道 (USART1_TX 固定为 DMA1 通道 4；接收走 RXNE 中断 + SPSC 环形缓冲区)
+#define  USART_TX_DMA_CHANNEL     DMA1_Channel4
+#define  USART_TX_DMA_IRQ         DMA1_Channel4_IRQn
+#define  USART_TX_DMA_IT_TC       DMA1_IT_TC4
 // 外设寄存器地址
 #define  USART_DR_ADDRESS        (USART1_BASE+0x04)
-// 一次发送的数据量
-#define  RECEIVEBUFF_SIZE            5000
+
+// 发送环形缓冲区 (DMA 搬运，写入方只拷贝到缓冲区即返回)
+// 协议应答与调试日志分两个通道排队，DMA 空闲时优先发协议通道
+#define  USART_TX_CH_PROTO        0        // 协议应答 (CMD:...)，见 Protocol_Reply
+#define  USART_TX_CH_LOG          1        // 调试日志 (printf)
+#define  USART_TX_CH_COUNT        2
+#define  USART_TX_PROTO_RING_SIZE 1024     // 必须是 2 的幂
+#define  USART_TX_LOG_RING_SIZE   2048     // 必须是 2 的幂
+#define  USART_TX_LOG_CHUNK       64       // 日志每段 DMA 最多字节数，决定协议应答的最长等待
+#define  USART_TX_POLICY_DROP     0        // 日志缓冲区满：丢弃并计数
+#define  USART_TX_POLICY_BLOCK    1        // 日志缓冲区满：等待 DMA 腾出空间 (中断中或关中断时仍按丢弃处理)
+#define  USART_TX_POLICY_DEFAULT  USART_TX_POLICY_BLOCK
+
+// 接收错误计数 (CMD:LINK_STATS)，由各串口接收中断调用 USART_Rx_Count_Errors() 累加
+typedef struct {
+	volatile uint32_t overrun;     // ORE：DR 未及时读走，硬件丢字节
+	volatile uint32_t framing;     // FE：帧错误 (波特率不匹配/线路干扰)
+	volatile uint32_t noise;       // NE：采样噪声
+} USART_Rx_Errors_t;
+
+// 接收链路统计快照，由各接收模块填写
+typedef struct {
+	uint32_t dropped;              // 接收环形缓冲区满丢弃的字节
+	uint16_t high_water;           // 接收环形缓冲区最高占用
+	uint16_t size;                 // 接收环形缓冲区容量
+	uint32_t overrun;
+	uint32_t framing;
+	uint32_t noise;
+	uint32_t truncated;            // 超过行缓冲区被截断的行 (仅协议口)
+} USART_Rx_Stats_t;
 
 void USART_Config(void);
-void USARTx_DMA_Config(void);
+uint16_t USART_TX_Write(uint8_t channel, const uint8_t *data, uint16_t len);
+uint16_t USART_TX_Write_Record(uint8_t channel, const uint8_t *data, uint16_t len);
+void USART_TX_Flush(void);
+void USART_TX_Set_Policy(uint8_t policy);
+uint32_t USART_TX_Get_Dropped(uint8_t channel);
+void USART_TX_DMA_IRQ_Handler(void);
+void USART_Set_Baudrate(uint32_t baudrate);
+uint32_t USART_Get_Baudrate(void);
+uint8_t USART_Is_Baudrate_Supported(uint32_t baudrate);
+void USART_Rx_Count_Errors(uint16_t sr, USART_Rx_Errors_t *err);
 void Usart_SendArray( USART_TypeDef * pUSARTx, uint8_t *array, uint16_t num);
 #endif /* __USARTDMA_H */
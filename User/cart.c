@@ -0,0 +1,181 @@
+#include "cart.h"
+#include "fmt.h"
+#include <string.h>
+
+static Cart_Line_t g_cart_lines[CART_MAX_LINES];
+static uint8_t g_cart_hash[CART_HASH_SIZE];     // 行号 + 1，0=空位
+static uint8_t g_cart_count;
+static uint32_t g_cart_total;                   // 分
+
+// 乘法哈希取高位：条码低位规律性强 (校验位、连续编号)，直接取模容易扎堆
+static uint16_t Cart_Hash(uint64_t id)
+{
+    return (uint16_t)((id * 0x9E3779B97F4A7C15ULL) >> (64 - CART_HASH_BITS));
+}
+
+// 返回条码所在槽位，不存在时返回应插入的空槽位 (表永远不会满)
+static uint16_t Cart_Probe(uint64_t id)
+{
+    uint16_t slot = Cart_Hash(id);
+
+    while (g_cart_hash[slot] != 0 && g_cart_lines[g_cart_hash[slot] - 1].id != id)
+    {
+        slot = (slot + 1) & (CART_HASH_SIZE - 1);
+    }
+    return slot;
+}
+
+void Cart_Clear(void)
+{
+    memset(g_cart_hash, 0, sizeof(g_cart_hash));
+    g_cart_count = 0;
+    g_cart_total = 0;
+}
+
+int Cart_Add(uint64_t id, uint32_t price, uint16_t count, uint8_t *is_new)
+{
+    uint16_t slot = Cart_Probe(id);
+    Cart_Line_t *line;
+
+    if (is_new != NULL)
+    {
+        *is_new = (g_cart_hash[slot] == 0);
+    }
+    if (g_cart_hash[slot] == 0)
+    {
+        if (g_cart_count >= CART_MAX_LINES)
+        {
+            return -1;
+        }
+        line = &g_cart_lines[g_cart_count];
+        line->id = id;
+        line->price = price;
+        line->count = 0;
+        line->reserved = 0;
+        g_cart_hash[slot] = ++g_cart_count;
+    }
+    else if (g_cart_lines[g_cart_hash[slot] - 1].count + (uint32_t)count > 0xFFFF)
+    {
+        return -1; // 数量会溢出 uint16_t：整笔拒绝，不截断
+    }
+    line = &g_cart_lines[g_cart_hash[slot] - 1];
+    line->count += count;
+    g_cart_total += line->price * (uint32_t)count;
+    return g_cart_hash[slot] - 1;
+}
+
+void Cart_Set_Count(int index, uint16_t count)
+{
+    Cart_Line_t *line = &g_cart_lines[index];
+
+    // 无符号回绕，数量减少时同样成立
+    g_cart_total += line->price * ((uint32_t)count - line->count);
+    line->count = count;
+}
+
+void Cart_Remove(int index)
+{
+    Cart_Line_t *line = &g_cart_lines[index];
+    uint16_t hole = Cart_Probe(line->id);
+    uint16_t slot = hole;
+
+    g_cart_total -= line->price * (uint32_t)line->count;
+
+    // 线性探测表不能直接清空槽位 (会截断后面的探测链)：把后面可以前移的项依次补进空位
+    for (;;)
+    {
+        uint16_t home;
+
+        slot = (slot + 1) & (CART_HASH_SIZE - 1);
+        if (g_cart_hash[slot] == 0)
+        {
+            break;
+        }
+        home = Cart_Hash(g_cart_lines[g_cart_hash[slot] - 1].id);
+        // home 不在 (hole, slot] 区间内，说明该项探测时经过了 hole，可以前移
+        if (((slot - home) & (CART_HASH_SIZE - 1)) >= ((slot - hole) & (CART_HASH_SIZE - 1)))
+        {
+            g_cart_hash[hole] = g_cart_hash[slot];
+            hole = slot;
+        }
+    }
+    g_cart_hash[hole] = 0;
+
+    // 后面的行整体前移一位，保持扫码顺序；哈希表中行号大于 index 的减 1
+    g_cart_count--;
+    memmove(line, line + 1, (g_cart_count - index) * sizeof(Cart_Line_t));
+    for (slot = 0; slot < CART_HASH_SIZE; slot++)
+    {
+        if (g_cart_hash[slot] > index + 1)
+        {
+            g_cart_hash[slot]--;
+        }
+    }
+}
+
+int Cart_Find(uint64_t id)
+{
+    return (int)g_cart_hash[Cart_Probe(id)] - 1;
+}
+
+int Cart_Count(void)
+{
+    return g_cart_count;
+}
+
+const Cart_Line_t *Cart_Get_Line(int index)
+{
+    return &g_cart_lines[index];
+}
+
+uint32_t Cart_Total(void)
+{
+    return g_cart_total;
+}
+
+void Cart_Load_Names(const uint8_t *lines, uint8_t n, char (*names)[CART_NAME_LENGTH])
+{
+    static Product_Item_t items[CART_NAME_BATCH];   // 静态分配，避免 640 字节占用栈
+    uint64_t ids[CART_NAME_BATCH];
+    uint8_t order[CART_NAME_BATCH];
+    uint8_t found[CART_NAME_BATCH];
+    uint8_t i, j, k;
+
+    if (n == 0)
+    {
+        return;
+    }
+    if (n > CART_NAME_BATCH)
+    {
+        n = CART_NAME_BATCH;
+    }
+    // Product_Find_Batch 要求条码升序；购物车里条码不重复，插入排序即可
+    for (i = 0; i < n; i++)
+    {
+        uint64_t id = g_cart_lines[lines[i]].id;
+
+        for (j = i; j > 0 && ids[j - 1] > id; j--)
+        {
+            ids[j] = ids[j - 1];
+            order[j] = order[j - 1];
+        }
+        ids[j] = id;
+        order[j] = i;
+    }
+    Product_Find_Batch(ids, n, items, found);
+
+    for (k = 0; k < n; k++)
+    {
+        char *name = names[order[k]];
+
+        if (found[k])
+        {
+            memcpy(name, items[k].name, CART_NAME_LENGTH);
+            name[CART_NAME_LENGTH - 1] = '\0';
+        }
+        else
+        {
+            *Fmt_U64(name, ids[k]) = '\0';
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef __CART_H
+#define __CART_H
+
+#include "stm32f10x.h"
+#include "products.h"
+
+// ==========================================
+// 购物车 (条码 -> 行号 的开放寻址哈希表)
+// ==========================================
+// 每行只保存结账需要的条码、单价、数量 (16 字节)，名称不在 RAM 里保存，
+// 显示时由 Cart_Load_Names() 按条码从 Flash 批量取回。扫码加购按条码查哈希表，O(1)。
+#define CART_MAX_LINES      128     // 不同商品种类上限 (行号用 uint8_t 存放，不能超过 254)
+#define CART_HASH_BITS      8
+#define CART_HASH_SIZE      (1u << CART_HASH_BITS)  // 至少为 CART_MAX_LINES 的 2 倍，保证探测链短
+#define CART_NAME_BATCH     10      // Cart_Load_Names 单次最多取的名称数
+#define CART_NAME_LENGTH    sizeof(((Product_Item_t *)0)->name)
+
+typedef struct {
+    uint64_t id;            // 条码
+    uint32_t price;         // 加入购物车时的单价 (分)
+    uint16_t count;         // 数量
+    uint16_t reserved;
+} Cart_Line_t;
+
+void Cart_Clear(void);
+// 按条码累加数量，新商品追加一行；返回行号，购物车已满或该行数量会超过 65535 返回 -1 (购物车不变)。is_new 可为 NULL
+int Cart_Add(uint64_t id, uint32_t price, uint16_t count, uint8_t *is_new);
+// 修改第 index 行的数量 (count > 0)，总价按差值调整
+void Cart_Set_Count(int index, uint16_t count);
+// 删除第 index 行：后面的行前移一位 (保持扫码顺序)，总价减去该行小计
+void Cart_Remove(int index);
+// 按条码查行号，不在购物车中返回 -1
+int Cart_Find(uint64_t id);
+int Cart_Count(void);
+const Cart_Line_t *Cart_Get_Line(int index);
+// 购物车总价 (分)，加购时累加，不用遍历
+uint32_t Cart_Total(void);
+// 取 lines[0..n) 各行的名称 (n 不超过 CART_NAME_BATCH)，Flash 只遍历一次；
+// 商品已从库中删除时用条码代替名称
+void Cart_Load_Names(const uint8_t *lines, uint8_t n, char (*names)[CART_NAME_LENGTH]);
+
+#endif
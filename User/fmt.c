@@ -0,0 +1,169 @@
+#include "fmt.h"
+#include <string.h>
+
+/**
+ * @brief  32 位无符号整数转十进制
+ * @note   除以常数 10 会被编译成乘法 + 移位，不调用除法库
+ */
+char *Fmt_U32(char *p, uint32_t v)
+{
+    char tmp[FMT_U32_MAX_LEN];
+    uint8_t n = 0;
+
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    while (n > 0)
+    {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+char *Fmt_U32_Pad(char *p, uint32_t v, uint8_t width, char pad)
+{
+    char tmp[FMT_U32_MAX_LEN];
+    uint8_t n = 0;
+
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    while (width > n)
+    {
+        *p++ = pad;
+        width--;
+    }
+    while (n > 0)
+    {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+/**
+ * @brief  64 位无符号整数转十进制 (条码)
+ * @note   13 位条码超过 32 位：先按 10^9 拆成高低两段，只做一两次 64 位除法，
+ *         其余位数按 32 位处理 (%llu 每一位都要调用一次 64 位除法)
+ */
+char *Fmt_U64(char *p, uint64_t v)
+{
+    uint64_t hi;
+
+    if ((v >> 32) == 0)
+    {
+        return Fmt_U32(p, (uint32_t)v);
+    }
+    hi = v / 1000000000ULL;
+    p = Fmt_U64(p, hi);
+    return Fmt_U32_Pad(p, (uint32_t)(v - hi * 1000000000ULL), 9, '0');
+}
+
+char *Fmt_Price(char *p, uint32_t cents, uint8_t int_width)
+{
+    uint32_t yuan = cents / 100;
+    uint32_t frac = cents - yuan * 100;
+
+    p = Fmt_U32_Pad(p, yuan, int_width, '0');
+    *p++ = '.';
+    *p++ = (char)('0' + frac / 10);
+    *p++ = (char)('0' + frac % 10);
+    return p;
+}
+
+char *Fmt_Str(char *p, const char *s)
+{
+    while (*s != '\0')
+    {
+        *p++ = *s++;
+    }
+    return p;
+}
+
+char *Fmt_Str_Pad(char *p, const char *s, uint8_t width)
+{
+    size_t len = strlen(s);
+
+    while (width > len)
+    {
+        *p++ = ' ';
+        width--;
+    }
+    memcpy(p, s, len);
+    return p + len;
+}
+
+#ifdef FMT_BENCHMARK
+#include <stdio.h>
+#include "log.h"
+
+// 旧版 core_cm3.h 没有 DWT 定义，直接按地址访问
+#define FMT_DEMCR       (*(volatile uint32_t *)0xE000EDFC)
+#define FMT_DWT_CTRL    (*(volatile uint32_t *)0xE0001000)
+#define FMT_DWT_CYCCNT  (*(volatile uint32_t *)0xE0001004)
+
+/**
+ * @brief  周期数对比：扫码应答行与购物车显示行，分别用原来的 snprintf 格式与本模块生成
+ */
+void Fmt_Benchmark(void)
+{
+    static char buf[128];
+    const uint64_t id = 6901234567892ULL;
+    const uint32_t price = 1250;
+    const char *name = "Cola";
+    uint32_t t0, c_float, c_int, c_fmt, l_float, l_fmt;
+    char *p;
+
+    FMT_DEMCR |= (1UL << 24);   // TRCENA
+    FMT_DWT_CYCCNT = 0;
+    FMT_DWT_CTRL |= 1UL;        // CYCCNTENA
+
+    // 1. 扫码应答 CMD:REPORT
+    t0 = FMT_DWT_CYCCNT;
+    snprintf(buf, sizeof(buf), "CMD:REPORT,ID:%llu,PR:%.2f,SEQ:%lu,NM:%s\n",
+             (unsigned long long)id, price / 100.0f, 17UL, name);
+    c_float = FMT_DWT_CYCCNT - t0;
+
+    t0 = FMT_DWT_CYCCNT;
+    snprintf(buf, sizeof(buf), "CMD:REPORT,ID:%llu,PR:%lu.%02lu,SEQ:%lu,NM:%s\n",
+             (unsigned long long)id, (unsigned long)(price / 100), (unsigned long)(price % 100), 17UL, name);
+    c_int = FMT_DWT_CYCCNT - t0;
+
+    t0 = FMT_DWT_CYCCNT;
+    p = Fmt_Str(buf, "CMD:REPORT,ID:");
+    p = Fmt_U64(p, id);
+    p = Fmt_Str(p, ",PR:");
+    p = Fmt_Price(p, price, 0);
+    p = Fmt_Str(p, ",SEQ:");
+    p = Fmt_U32(p, 17);
+    p = Fmt_Str(p, ",NM:");
+    p = Fmt_Str(p, name);
+    *p++ = '\n';
+    c_fmt = FMT_DWT_CYCCNT - t0;
+
+    // 2. 串口屏购物车行 (原 TJCPrintf 格式)
+    t0 = FMT_DWT_CYCCNT;
+    snprintf(buf, sizeof(buf), "t1.txt+=\"%7s,%07.2f,%07d\r\n\"", name, price / 100.0f, 3);
+    l_float = FMT_DWT_CYCCNT - t0;
+
+    t0 = FMT_DWT_CYCCNT;
+    p = Fmt_Str(buf, "t1.txt+=\"");
+    p = Fmt_Str_Pad(p, name, 7);
+    *p++ = ',';
+    p = Fmt_Price(p, price, 4);
+    *p++ = ',';
+    p = Fmt_U32_Pad(p, 3, 7, '0');
+    p = Fmt_Str(p, "\r\n\"");
+    l_fmt = FMT_DWT_CYCCNT - t0;
+
+    LOG_I("[Fmt] REPORT: snprintf(%%.2f) %lu, snprintf(int) %lu, fmt %lu cycles\r\n",
+          (unsigned long)c_float, (unsigned long)c_int, (unsigned long)c_fmt);
+    LOG_I("[Fmt] Cart line: snprintf(%%07.2f) %lu, fmt %lu cycles\r\n",
+          (unsigned long)l_float, (unsigned long)l_fmt);
+}
+#endif
@@ -0,0 +1,32 @@
+#ifndef __FMT_H
+#define __FMT_H
+
+#include "stm32f10x.h"
+
+// ==========================================
+// 热路径用的专用格式化 (代替 printf / vsnprintf)
+// ==========================================
+// 所有函数把结果直接写到 p 指向的缓冲区，返回写入后的末尾指针，不补 '\0'，便于连续拼接：
+//     p = Fmt_Str(p, "ID:"); p = Fmt_U64(p, id); ...
+// 不检查缓冲区长度，调用方按下面的最大长度预留空间
+#define FMT_U32_MAX_LEN     10      // 4294967295
+#define FMT_U64_MAX_LEN     20      // 18446744073709551615
+#define FMT_PRICE_MAX_LEN   11      // 42949672.95
+
+char *Fmt_U32(char *p, uint32_t v);
+char *Fmt_U64(char *p, uint64_t v);
+// 右对齐，不足 width 位时左侧补 pad (' ' 或 '0')，超出不截断；相当于 %0*lu / %*lu
+char *Fmt_U32_Pad(char *p, uint32_t v, uint8_t width, char pad);
+// 价格 (分) -> "元.分"，元部分至少 int_width 位、左侧补 0；相当于 PRICE_FMT / "%04lu.%02lu"
+char *Fmt_Price(char *p, uint32_t cents, uint8_t int_width);
+// 拷贝字符串 (不含结尾 0)
+char *Fmt_Str(char *p, const char *s);
+// 右对齐字符串，不足 width 时左侧补空格；相当于 %*s
+char *Fmt_Str_Pad(char *p, const char *s, uint8_t width);
+
+// 在工程宏定义中加入 FMT_BENCHMARK，上电时用 DWT 周期计数器对比 snprintf 与本模块的耗时
+#ifdef FMT_BENCHMARK
+void Fmt_Benchmark(void);
+#endif
+
+#endif
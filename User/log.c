@@ -0,0 +1,167 @@
+#include "log.h"
+#include "bsp_usart_dma.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static volatile uint8_t g_log_level = LOG_LEVEL_DEFAULT;
+static volatile uint32_t g_log_rate = LOG_RATE_DEFAULT;
+static volatile uint32_t g_log_budget = LOG_RATE_DEFAULT;   // 本秒剩余可输出字节数
+static volatile uint32_t g_log_suppressed = 0;
+
+// 各二进制日志 ID 的等级 (格式串不进固件)
+static const uint8_t g_log_id_level[LOG_ID_COUNT] =
+{
+#define LOG_DEF(id, level, fmt) level,
+    LOG_ID_TABLE
+#undef LOG_DEF
+};
+
+// 等级过滤 + 限速额度检查，额度用完时计入丢弃条数
+static uint8_t Log_Allow(uint8_t level)
+{
+    if (level == LOG_LEVEL_OFF || level > g_log_level)
+    {
+        return 0;
+    }
+    if (g_log_rate != 0 && g_log_budget == 0)
+    {
+        g_log_suppressed++;
+        return 0;
+    }
+    return 1;
+}
+
+// 扣除本秒额度
+static void Log_Charge(int len)
+{
+    if (g_log_rate != 0 && len > 0)
+    {
+        g_log_budget = ((uint32_t)len < g_log_budget) ? g_log_budget - len : 0;
+    }
+}
+
+/**
+  * @brief  分级日志输出 (整行格式化后一次写入日志通道)
+  * @note   限速按整条判断：额度未用完就整条输出，用完后整条丢弃并计数，不会输出半行；
+  *         超过 LOG_LINE_MAX 的行截断并补上 "\r\n"，缓冲区放不下时整行丢弃并计数
+  * @retval 输出的字节数，被过滤或丢弃时为 0
+  */
+int Log_Printf(uint8_t level, const char *fmt, ...)
+{
+    char line[LOG_LINE_MAX];
+    va_list args;
+    int len;
+
+    if (!Log_Allow(level))
+    {
+        return 0;
+    }
+
+    va_start(args, fmt);
+    len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (len <= 0)
+    {
+        return 0;
+    }
+    if (len >= (int)sizeof(line))
+    {
+        len = sizeof(line) - 1;
+        line[len - 2] = '\r';
+        line[len - 1] = '\n';
+    }
+
+    if (USART_TX_Write_Record(USART_TX_CH_LOG, (const uint8_t *)line, (uint16_t)len) == 0)
+    {
+        g_log_suppressed++;
+        return 0;
+    }
+    Log_Charge(len);
+    return len;
+}
+
+/**
+  * @brief  输出一帧二进制日志 (LOG_BIN 宏调用)
+  * @note   只做字节拷贝与转义，帧整体写入日志通道，格式化交给上位机
+  */
+void Log_Bin_Write(uint16_t id, const uint32_t *args, uint8_t argc)
+{
+    uint8_t raw[3 + 4 * LOG_BIN_MAX_ARGS];
+    uint8_t frame[2 + 2 * sizeof(raw)];
+    uint16_t raw_len = 0;
+    uint16_t len = 0;
+    uint16_t i;
+
+    if (id >= LOG_ID_COUNT || !Log_Allow(g_log_id_level[id]))
+    {
+        return;
+    }
+    if (argc > LOG_BIN_MAX_ARGS)
+    {
+        argc = LOG_BIN_MAX_ARGS;
+    }
+
+    raw[raw_len++] = (uint8_t)id;
+    raw[raw_len++] = (uint8_t)(id >> 8);
+    raw[raw_len++] = argc;
+    for (i = 0; i < argc; i++)
+    {
+        raw[raw_len++] = (uint8_t)args[i];
+        raw[raw_len++] = (uint8_t)(args[i] >> 8);
+        raw[raw_len++] = (uint8_t)(args[i] >> 16);
+        raw[raw_len++] = (uint8_t)(args[i] >> 24);
+    }
+
+    frame[len++] = LOG_BIN_START;
+    for (i = 0; i < raw_len; i++)
+    {
+        uint8_t b = raw[i];
+        if (b == '\n' || b == LOG_BIN_START || b == LOG_BIN_ESC)
+        {
+            frame[len++] = LOG_BIN_ESC;
+            b ^= 0x20;
+        }
+        frame[len++] = b;
+    }
+    frame[len++] = '\n';
+
+    // 整帧写入，放不下就整帧丢弃，不留下半帧让上位机解出 <bad frame>
+    if (USART_TX_Write_Record(USART_TX_CH_LOG, frame, len) == 0)
+    {
+        g_log_suppressed++;
+        return;
+    }
+    Log_Charge(len);
+}
+
+void Log_Set_Level(uint8_t level)
+{
+    g_log_level = (level > LOG_LEVEL_DEBUG) ? LOG_LEVEL_DEBUG : level;
+}
+
+uint8_t Log_Get_Level(void)
+{
+    return g_log_level;
+}
+
+void Log_Set_Rate(uint32_t bytes_per_s)
+{
+    g_log_rate = bytes_per_s;
+    g_log_budget = bytes_per_s;
+}
+
+uint32_t Log_Get_Rate(void)
+{
+    return g_log_rate;
+}
+
+uint32_t Log_Get_Suppressed(void)
+{
+    return g_log_suppressed;
+}
+
+void Log_Tick_1Hz(void)
+{
+    g_log_budget = g_log_rate;
+}
@@ -0,0 +1,73 @@
+#ifndef __LOG_H
+#define __LOG_H
+
+#include "stm32f10x.h"
+#include <stdio.h>
+
+// ================== 日志等级 ==================
+// 等级数值不大于当前等级的日志才会输出，LOG_LEVEL_OFF 关闭全部分级日志
+#define LOG_LEVEL_OFF       0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4   // 传感器轮询、购物车明细等高频输出
+#define LOG_LEVEL_DEFAULT   LOG_LEVEL_DEBUG
+
+// 默认不限速 (字节/秒，0=不限)
+#define LOG_RATE_DEFAULT    0
+
+// 一行文本日志的最大长度 (含 "\r\n")，Log_Printf 在栈上格式化后整行写入，超长截断
+#define LOG_LINE_MAX        160
+
+// ================== 二进制日志帧 ==================
+// 0x1E | ID 低字节 | ID 高字节 | 参数个数 | 参数 (每个 4 字节小端) ... | '\n'
+// 帧内出现 0x0A/0x1E/0x1B 时写成 0x1B, (字节 ^ 0x20)，所以帧内不会有换行，
+// 文本行与二进制帧可以混在日志通道里，由 tools/log_decode.py 还原成文本
+#define LOG_BIN_START       0x1E
+#define LOG_BIN_ESC         0x1B
+#define LOG_BIN_MAX_ARGS    8
+
+#include "log_ids.h"
+
+typedef enum
+{
+#define LOG_DEF(id, level, fmt) id,
+    LOG_ID_TABLE
+#undef LOG_DEF
+    LOG_ID_COUNT
+} LogId_t;
+
+// ================== 输出宏 ==================
+// 日志走 USART1 的日志通道，协议应答 (Protocol_Reply) 优先发送，互不插行
+#define LOG_E(...)  Log_Printf(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_W(...)  Log_Printf(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_I(...)  Log_Printf(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_D(...)  Log_Printf(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// 二进制日志：LOG_BIN(LOG_ID_SYNC_PROGRESS, cnt, total)，至少一个参数，最多 LOG_BIN_MAX_ARGS 个
+// 只拷贝参数、不格式化，高频位置 (中断、同步循环) 用这个代替 LOG_x
+#define LOG_BIN(id, ...) \
+    do { \
+        const uint32_t _log_args[] = {__VA_ARGS__}; \
+        Log_Bin_Write((id), _log_args, sizeof(_log_args) / sizeof(_log_args[0])); \
+    } while (0)
+
+// float 按位传给 LOG_BIN，由上位机还原
+static __inline uint32_t LOG_F32(float f)
+{
+    union { float f; uint32_t u; } v;
+    v.f = f;
+    return v.u;
+}
+
+// ================== 函数声明 ==================
+int Log_Printf(uint8_t level, const char *fmt, ...);
+void Log_Bin_Write(uint16_t id, const uint32_t *args, uint8_t argc);
+void Log_Set_Level(uint8_t level);
+uint8_t Log_Get_Level(void);
+void Log_Set_Rate(uint32_t bytes_per_s);   // 运行时限速，按整行放行/丢弃
+uint32_t Log_Get_Rate(void);
+uint32_t Log_Get_Suppressed(void);         // 因限速或发送缓冲区满丢弃的日志条数 (文本与二进制合计)
+void Log_Tick_1Hz(void);                   // 每秒补充限速额度 (TIM2 中断中调用)
+
+#endif
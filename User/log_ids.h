@@ -0,0 +1,22 @@
+#ifndef __LOG_IDS_H
+#define __LOG_IDS_H
+
+// ==========================================
+// 二进制日志 ID 表 (LOG_BIN 使用)
+// ==========================================
+// LOG_DEF(ID 名, 等级, "格式串")
+// - 只追加，不要删除或调整顺序：ID 即表中序号，上位机按同一张表解码
+// - 格式串只被 tools/log_decode.py 读取，不会编译进固件
+// - 每个参数在帧中都是 32 位小端整数，格式说明符：
+//     %u %lu %d %x %X %08lX ...  整数 (%d 按有符号解释)
+//     %f %.2f                     参数是 float 的位模式 (用 LOG_F32() 传入，固件不做浮点格式化)
+//     %{A|B|C}                    枚举，按参数值取第几项
+#define LOG_ID_TABLE \
+    LOG_DEF(LOG_ID_SENSOR,        LOG_LEVEL_DEBUG, "[Sensor] Temperature: %.2f C, Humidity: %u %%") \
+    LOG_DEF(LOG_ID_SHOP_STATE,    LOG_LEVEL_DEBUG, "[State] Current Shopping State: %{IDLE|SCANNING|WAITING_PAYOFF|EMMERGENCY|SYNCING}") \
+    LOG_DEF(LOG_ID_SYNC_START,    LOG_LEVEL_INFO,  "<< SYNC_START >> Expecting %u items.") \
+    LOG_DEF(LOG_ID_SYNC_PROGRESS, LOG_LEVEL_INFO,  "[Log] Sync Progress: %u/%u") \
+    LOG_DEF(LOG_ID_SYNC_END,      LOG_LEVEL_INFO,  "<< SYNC_END >> Recv: %u, PC_Sum: %u") \
+    LOG_DEF(LOG_ID_SYNC_RESUME,   LOG_LEVEL_INFO,  "<< SYNC_RESUME >> Continue at %u/%u.")
+
+#endif
@@ -22,8 +22,12 @@ int main(void)
     // 2. 中间件与协议初始化
     // ---------------------------------------------------------
     Protocol_Init();        // 初始化协议环形缓冲区
+    Scanner_Init();         // 扫码枪直连串口 (DMA 循环接收)
     Product_Manager_Init(); // 初始化商品管理器 (读取元数据，恢复总数)
     Product_Debug_Dump_All();
+#ifdef FMT_BENCHMARK
+    Fmt_Benchmark();        // 输出格式化耗时对比 (周期数)
+#endif
     Setup_TIM2_Interrupt(); // 初始化 TIM2 定时器 (0.5s 周期中断)
 
     BEEP(OFF);
@@ -36,10 +40,11 @@ int main(void)
     delay_ms(50); // 等待传感器稳定
     **/
     DS18B20_Init();
-    printf("[System] DS18B20_Init Complete.\r\n");
+    LOG_I("[System] DS18B20_Init Complete.\r\n");
     delay_ms(50);
     // 3. 主循环 (无限状态机)
     // ---------------------------------------------------------
+    uint32_t now_ms;
     while (1)
     {
         // if (sensor_data.temper > MAX_TEMPER || (sensor_data.humidity > MAX_HUMIDITY && sensor_data.humidity < 100))
@@ -62,15 +67,26 @@ int main(void)
         // 进入上位机服务函数，检查环形队列是否有更新
         callSyncHandler();
 
+        // 串口屏：先解码屏幕返回帧 (触摸/按钮事件)，再限帧刷新 (购物车/总价/提示信息的改动在这里合并发送)
+        now_ms = Get_Tick_Ms();
+        TJC_Poll_Frames(now_ms);
+        Screen_Cart_Op_Poll();
+        Screen_Render_Task(now_ms);
+
         switch (ShoppingState)
         {
         case SHOP_STATE_IDLE:
             // 空闲状态，等待扫码
             // clear_shopping_car();
             // printf("clear_shopping_car...\r\n");
+            // 无顾客时顺便整理增量日志，避免日志写满时在扫码过程中整理
+            if (SlaveState == SYS_STATE_IDLE && Product_Delta_Count() >= DELTA_COMPACT_THRESHOLD)
+            {
+                Product_Delta_Compact();
+            }
             if (Screen_Check_Start_Shopping_Msg())
             {
-                printf("[Shop] Shopping Started.\r\n");
+                LOG_I("[Shop] Shopping Started.\r\n");
                 control_Servo_Door(1);
                 delay_ms(800); // 等待舵机动作完成
                 control_Servo_Door(0);
@@ -94,21 +110,21 @@ int main(void)
             // 非阻塞：等待按键确认，超过 30s 自动返回扫码
             if (Key_Scan(KEY2_GPIO_PORT, KEY2_GPIO_PIN) == KEY_ON)
             {
-                printf("[Shop] Payment Confirmed. Switching to IDLE state.\r\n");
-                printf("CMD:PAY_OFF,TOTAL:%.2f\n", total_price);
+                LOG_I("[Shop] Payment Confirmed. Switching to IDLE state.\r\n");
+                Protocol_Reply("CMD:PAY_OFF,TOTAL:" PRICE_FMT "\n", PRICE_ARGS(Cart_Total()));
                 control_Servo_Door(1);
                 delay_ms(800); // 等待舵机动作完成
                 control_Servo_Door(0);
                 Shop_transtate(SHOP_STATE_IDLE);
                 clear_shopping_car();
-                TJCPrintf("t4.txt=\"shopping finished\r\n\"");
+                Screen_Set_Text("t4", "shopping finished\r\n");
             }
             else
             {
                 if ((uint32_t)(g_tim2_tick_s - g_waiting_payoff_start_s) >= 30U)
                 {
                     Shop_transtate(SHOP_STATE_SCANNING);
-                    TJCPrintf("t4.txt=\"shopping out-time\r\n\"");
+                    Screen_Set_Text("t4", "shopping out-time\r\n");
                 }
             }
             break;
@@ -126,12 +142,59 @@ int main(void)
     }
 }
 
+// 毫秒时间戳：TIM2 秒计数 + 当前计数值 (10kHz，0.1ms 一格)
+// 计数刚回绕而更新中断还没执行时，秒计数按已进位处理，保证时间不倒退
+uint32_t Get_Tick_Ms(void)
+{
+    uint32_t s, cnt;
+    uint8_t pending;
+
+    do
+    {
+        s = g_tim2_tick_s;
+        cnt = TIM2->CNT;
+        pending = (TIM2->SR & TIM_FLAG_Update) != 0;
+    } while (s != g_tim2_tick_s);
+
+    if (pending && cnt < 5000U)
+    {
+        s++;
+    }
+    return s * 1000U + cnt / 10U;
+}
+
+// 新波特率试用超时检查：规定时间内没有收到完整的 PING，说明链路不可用，回退到原波特率
+void Baud_Trial_Check(void)
+{
+    if (baud_fallback != 0 && (uint32_t)(g_tim2_tick_s - baud_trial_start_s) >= BAUD_VERIFY_TIMEOUT_S)
+    {
+        USART_Set_Baudrate(baud_fallback);
+        baud_fallback = 0;
+        LOG_W("[Baud] Verify Timeout, Fallback to %lu.\r\n", (unsigned long)USART_Get_Baudrate());
+    }
+}
+
 // 调用数据同步所用的从机状态机
 void callSyncHandler(void)
 {
-    // 尝试从协议缓冲区解析一条完整指令 (非阻塞)
-    if (Protocol_Parse_Line(&rx_packet))
+    Baud_Trial_Check();
+
+    // 尝试从协议缓冲区解析完整指令 (非阻塞)
+    // 连续到达的扫码先入队，队列满或遇到其他指令时再按顺序处理，屏幕只刷新一次
+    while (Protocol_Parse_Line(&rx_packet))
     {
+        if (rx_packet.event == EVENT_SCAN && SlaveState == SYS_STATE_IDLE)
+        {
+            Scan_Queue_Push(&rx_packet);
+            if (scan_queue_count < SCAN_QUEUE_DEPTH)
+            {
+                continue;
+            }
+            break;
+        }
+
+        // 其他指令必须排在已入队的扫码之后执行
+        Scan_Queue_Flush();
 
         // 状态机根据当前状态和接收到的事件进行处理
         switch (rx_packet.event)
@@ -148,26 +211,30 @@ void callSyncHandler(void)
                 Shop_transtate(SHOP_STATE_SYNCING);
 
                 sync_expect_total = rx_packet.total_count;
-                printf("<< SYNC_START >> Expecting %d items.\r\n", sync_expect_total);
+                LOG_BIN(LOG_ID_SYNC_START, sync_expect_total);
 
                 // [状态切换] 进入同步启动状态
                 Slave_transtate(SYS_STATE_SYNC_START);
 
                 // [核心操作] 格式化数据库 (耗时操作：擦除 Flash 扇区)
                 // 注意：PC 端发送 START 后会进入等待，所以这里阻塞是安全的
-                Product_Clear_Database();
+                Product_Clear_Database(sync_expect_total);
 
                 // [握手信号] 发送 REQ_SYNC 告诉 PC: "擦除完毕，请发送数据"
                 // 对应文档中的 "阶段二：握手成功"
-                printf("CMD:REQ_SYNC\n");
+                Protocol_Reply("CMD:REQ_SYNC\n");
 
                 // [状态切换] 进入接收数据状态
                 Slave_transtate(SYS_STATE_SYNC_ING);
                 sync_received_cnt = 0;
+                sync_checksum = PRODUCT_CHECKSUM_INIT;
+
+                // 记录初始检查点，即使第一批数据前断电也能续传
+                Product_Save_Sync_Progress(sync_expect_total, sync_received_cnt, sync_checksum);
             }
             else
             {
-                printf("CMD:ALARM,MSG:Busy_Syncing\n");
+                Protocol_Reply("CMD:ALARM,MSG:Busy_Syncing\n");
             }
             break;
 
@@ -180,7 +247,13 @@ void callSyncHandler(void)
             {
                 if (!rx_packet.id_valid)
                 {
-                    printf("CMD:ALARM,LEVEL:2,MSG:Invalid_ID\n");
+                    Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:Invalid_ID\n");
+                    break;
+                }
+                // 超出 SYNC_START 声明的数量 (擦除范围) 或容量上限的数据不写入
+                if (sync_received_cnt >= sync_expect_total || sync_received_cnt >= PRODUCT_MAX_COUNT)
+                {
+                    Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:DB_Full\n");
                     break;
                 }
                 // [核心操作] 写入 Flash
@@ -191,38 +264,53 @@ void callSyncHandler(void)
                                    rx_packet.name);
 
                 sync_received_cnt++;
+                sync_checksum = Product_Checksum_Update(sync_checksum,
+                                                        rx_packet.id,
+                                                        rx_packet.price,
+                                                        rx_packet.name);
+
+                // 定期保存检查点，中断后只需重发最后一个检查点之后的数据
+                if (sync_received_cnt % SYNC_CHECKPOINT_INTERVAL == 0)
+                {
+                    Product_Save_Sync_Progress(sync_expect_total, sync_received_cnt, sync_checksum);
+                }
 
                 // 可选：每接收 50 条打印一次进度日志 (避免串口刷屏)
                 if (sync_received_cnt % 50 == 0)
                 {
-                    printf("[Log] Sync Progress: %d/%d\r\n", sync_received_cnt, sync_expect_total);
+                    LOG_BIN(LOG_ID_SYNC_PROGRESS, sync_received_cnt, sync_expect_total);
                 }
             }
             break;
 
         // ---------------------------------------------------------
         // 场景 C: 收到同步结束指令 (PC -> STM32)
-        // 指令: CMD:SYNC_END,SUM:100
+        // 指令: CMD:SYNC_END,SUM:100[,VER:7,TS:1700000000]
         // ---------------------------------------------------------
         case EVENT_SYNC_END:
             if (SlaveState == SYS_STATE_SYNC_ING)
             {
-                printf("<< SYNC_END >> Recv: %d, PC_Sum: %d\r\n", sync_received_cnt, rx_packet.total_count);
+                LOG_BIN(LOG_ID_SYNC_END, sync_received_cnt, rx_packet.total_count);
 
                 // [校验] 检查接收数量是否与 PC 发送数量一致
                 if (sync_received_cnt == rx_packet.total_count)
                 {
                     // 校验通过：更新 Flash 中的元数据 (Total Count)
-                    Product_Update_Metadata(sync_received_cnt);
-                    printf("[Success] Database Updated Successfully.\r\n");
+                    // 未携带 VER 时版本号自动加 1，保证 HELLO 握手能发现变化
+                    Product_Metadata_t meta;
+                    Product_Get_Metadata(&meta);
+                    Product_Update_Metadata(sync_received_cnt,
+                                            rx_packet.version_valid ? rx_packet.version : meta.version + 1,
+                                            rx_packet.timestamp);
+                    LOG_I("[Success] Database Updated Successfully.\r\n");
 
                     // 蜂鸣器提示可以加在这里...
                 }
                 else
                 {
                     // 校验失败
-                    printf("[Error] Data Count Mismatch!\r\n");
-                    printf("CMD:ALARM,LEVEL:2,MSG:Sync_Mismatch_Error\n");
+                    LOG_E("[Error] Data Count Mismatch!\r\n");
+                    Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:Sync_Mismatch_Error\n");
                 }
 
                 // [状态切换] 恢复空闲，允许扫码
@@ -233,61 +321,609 @@ void callSyncHandler(void)
             break;
 
         // ---------------------------------------------------------
-        // 场景 D: 模拟扫码 / 实际扫码 (PC/Scanner -> STM32)
-        // 指令: CMD:SCAN,ID:6912345
+        // 场景 C2: 断点续传查询 (PC -> STM32)
+        // 指令: CMD:SYNC_RESUME
+        // 回复: CMD:RESUME_AT,TOTAL:100,CNT:64,SUM:1A2B3C4D
+        //       PC 比对 SUM 后从第 CNT 条继续发送 SYNC_DATA；不一致则重新 SYNC_START
         // ---------------------------------------------------------
-        case EVENT_SCAN:
+        case EVENT_SYNC_RESUME:
             if (SlaveState == SYS_STATE_IDLE)
             {
-                if (!rx_packet.id_valid)
+                Product_Sync_Progress_t progress;
+
+                // 复位后从 Flash 检查点恢复
+                if (!Product_Load_Sync_Progress(&progress))
+                {
+                    Protocol_Reply("CMD:ALARM,LEVEL:1,MSG:No_Sync_To_Resume\n");
+                    break;
+                }
+                Shop_transtate(SHOP_STATE_SYNCING);
+                sync_expect_total = progress.expect_total;
+                sync_received_cnt = progress.received_cnt;
+                sync_checksum = progress.checksum;
+                Slave_transtate(SYS_STATE_SYNC_ING);
+            }
+            // 未复位 (仅断线重连) 时 RAM 中的进度即为最新，直接上报
+
+            LOG_BIN(LOG_ID_SYNC_RESUME, sync_received_cnt, sync_expect_total);
+            Protocol_Reply("CMD:RESUME_AT,TOTAL:%lu,CNT:%lu,SUM:%08lX\n",
+                           (unsigned long)sync_expect_total,
+                           (unsigned long)sync_received_cnt,
+                           (unsigned long)sync_checksum);
+            break;
+
+        // ---------------------------------------------------------
+        // 场景 C3: 增量更新单个商品 (PC -> STM32)，无需全量同步
+        // 指令: CMD:UPSERT,ID:6901234567892,PR:6.50[,VER:8],NM:可乐
+        //       CMD:DELETE,ID:6901234567892[,VER:8]
+        // ---------------------------------------------------------
+        case EVENT_UPSERT:
+        case EVENT_DELETE:
+            if (SlaveState != SYS_STATE_IDLE)
+            {
+                Protocol_Reply("CMD:ALARM,MSG:Busy_Syncing\n");
+                break;
+            }
+            if (!rx_packet.id_valid)
+            {
+                Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:Invalid_ID\n");
+                break;
+            }
+            {
+                Product_Item_t item;
+                uint8_t ok;
+
+                if (rx_packet.event == EVENT_DELETE && !Product_Find_By_ID(rx_packet.id, &item))
+                {
+                    Protocol_Reply("CMD:ALARM,LEVEL:1,MSG:Item_Not_Found\n");
+                    break;
+                }
+                ok = (rx_packet.event == EVENT_UPSERT)
+                         ? Product_Upsert(rx_packet.id, rx_packet.price, rx_packet.name)
+                         : Product_Delete(rx_packet.id);
+                if (!ok)
                 {
-                    printf("CMD:ALARM,LEVEL:2,MSG:Invalid_ID\n");
+                    Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:DB_Full\n");
                     break;
                 }
-                Product_Item_t result_item;
-                // printf("[Scan] Searching ID: %d ...\r\n", rx_packet.id);
 
-                // [核心操作] 在 Flash 中查找 ID
-                if (Product_Find_By_ID(rx_packet.id, &result_item))
+                // 版本记录紧跟变更写入，同时保存更新后的内容校验和；未携带 VER 时版本号不变
+                Product_Metadata_t meta;
+                Product_Get_Metadata(&meta);
+                Product_Set_Version(rx_packet.version_valid ? rx_packet.version : meta.version);
+                if (rx_packet.event == EVENT_UPSERT)
                 {
-                    // 找到商品 -> 上报销售信息
-                    // 格式: CMD:REPORT,ID:xxx,PR:xxx,NM:xxx
-                    printf("CMD:REPORT,ID:%llu,PR:%.2f,NM:%s\n",
-                           (unsigned long long)result_item.id,
-                           result_item.price,
-                           result_item.name);
-                    // 同时添加到购物车
-                    add_product_to_shopping_car(&result_item);
-                    // 调试：打印购物车情况
-                    debug_print_shopping_car();
-
-                    refresh_MCU_products_list();
-                    Screen_Update_HMI_Shopping_List();
-                    Screen_Calculate_And_Send_Total();
+                    Protocol_Reply("CMD:UPSERT_OK,ID:%llu\n", (unsigned long long)rx_packet.id);
                 }
                 else
                 {
-                    // 未找到 -> 报警
-                    printf("CMD:ALARM,LEVEL:1,MSG:Item_Not_Found\n");
+                    Protocol_Reply("CMD:DELETE_OK,ID:%llu\n", (unsigned long long)rx_packet.id);
                 }
             }
+            break;
+
+        // ---------------------------------------------------------
+        // 场景 C4: 商品库版本握手 (PC -> STM32)
+        // 指令: CMD:HELLO 或 CMD:DB_INFO
+        // 回复: CMD:DB_INFO,VER:7,CNT:100,HASH:1A2B3C4D,TS:1700000000,DELTA:0
+        //       PC 端版本与校验和一致时可跳过整次同步
+        // ---------------------------------------------------------
+        case EVENT_HELLO:
+            if (SlaveState != SYS_STATE_IDLE)
+            {
+                Protocol_Reply("CMD:ALARM,MSG:Busy_Syncing\n");
+                break;
+            }
+            {
+                Product_Metadata_t meta;
+                Product_Get_Metadata(&meta);
+                Protocol_Reply("CMD:DB_INFO,VER:%lu,CNT:%lu,HASH:%08lX,TS:%lu,DELTA:%lu\n",
+                               (unsigned long)meta.version,
+                               (unsigned long)meta.total_count,
+                               (unsigned long)meta.content_hash,
+                               (unsigned long)meta.update_timestamp,
+                               (unsigned long)Product_Delta_Count());
+            }
+            break;
+
+        // ---------------------------------------------------------
+        // 场景 C5: 波特率协商 (PC -> STM32)
+        // 指令: CMD:SET_BAUD,BAUD:921600
+        // 流程: 旧波特率回 CMD:BAUD_ACK -> 双方切换 -> PC 以新波特率发 CMD:PING
+        //       -> 回 CMD:PONG 确认；BAUD_VERIFY_TIMEOUT_S 内收不到 PING 则双方回退
+        // ---------------------------------------------------------
+        case EVENT_SET_BAUD:
+            if (baud_fallback != 0 || !USART_Is_Baudrate_Supported(rx_packet.baudrate))
+            {
+                Protocol_Reply("CMD:ALARM,LEVEL:1,MSG:Baud_Unsupported\n");
+                break;
+            }
+            Protocol_Reply("CMD:BAUD_ACK,BAUD:%lu\n", (unsigned long)rx_packet.baudrate);
+
+            // USART_Set_Baudrate 会等应答发送完毕再切换
+            baud_fallback = USART_Get_Baudrate();
+            baud_trial_start_s = g_tim2_tick_s;
+            USART_Set_Baudrate(rx_packet.baudrate);
+            break;
+
+        case EVENT_PING:
+            if (baud_fallback != 0)
+            {
+                // 新波特率下收到完整指令，确认切换
+                baud_fallback = 0;
+            }
+            Protocol_Reply("CMD:PONG,BAUD:%lu\n", (unsigned long)USART_Get_Baudrate());
+            break;
+
+        // ---------------------------------------------------------
+        // 场景 D: 模拟扫码 / 实际扫码 (PC/Scanner -> STM32)
+        // 指令: CMD:SCAN,ID:6901234567892[,SEQ:17]
+        // 空闲时扫码在上面入队，由 Scan_Queue_Flush() 处理；走到这里说明正在同步
+        // ---------------------------------------------------------
+        case EVENT_SCAN:
+            // 如果正在同步时扫码，提示系统忙
+            Protocol_Reply("CMD:ALARM,MSG:System_Busy%s\n", Seq_Field(rx_packet.seq_valid, rx_packet.seq));
+            break;
+
+        // ---------------------------------------------------------
+        // 场景 D2: 整篮扫码 (通道式扫码枪一次读出多件商品)
+        // 指令: CMD:SCAN_BATCH,IDS:6901234567892;6901234567908;6901234567892[,SEQ:18]
+        // ---------------------------------------------------------
+        case EVENT_SCAN_BATCH:
+            if (SlaveState == SYS_STATE_IDLE)
+            {
+                Scan_Batch_Handler(&rx_packet);
+            }
             else
             {
-                // 如果正在同步时扫码，提示系统忙
-                printf("CMD:ALARM,MSG:System_Busy\n");
+                Protocol_Reply("CMD:ALARM,MSG:System_Busy%s\n", Seq_Field(rx_packet.seq_valid, rx_packet.seq));
+            }
+            break;
+
+        // ---------------------------------------------------------
+        // 场景 E: 调试日志配置 (PC -> STM32)
+        // 指令: CMD:LOG[,LEVEL:0-4][,RATE:字节每秒]  LEVEL:0 关闭，RATE:0 不限速，缺省字段保持不变
+        // 回复: CMD:LOG_OK,LEVEL:3,RATE:2000,SUPP:12,DROP:0 (SUPP=限速丢弃条数，DROP=日志缓冲区满丢弃字节数)
+        // ---------------------------------------------------------
+        case EVENT_LOG_CFG:
+            if (rx_packet.log_level_valid)
+            {
+                Log_Set_Level(rx_packet.log_level);
+            }
+            if (rx_packet.log_rate_valid)
+            {
+                Log_Set_Rate(rx_packet.log_rate);
             }
+            Protocol_Reply("CMD:LOG_OK,LEVEL:%u,RATE:%lu,SUPP:%lu,DROP:%lu\n",
+                           Log_Get_Level(),
+                           (unsigned long)Log_Get_Rate(),
+                           (unsigned long)Log_Get_Suppressed(),
+                           (unsigned long)USART_TX_Get_Dropped(USART_TX_CH_LOG));
             break;
+
+        // ---------------------------------------------------------
+        // 场景 F: 串口链路统计 (PC -> STM32)，用于区分线路错误和本机缓冲区溢出、按实测调整缓冲区
+        // 指令: CMD:LINK_STATS
+        // 回复: CMD:LINK_STATS,RX_DROP:0,RX_HWM:312/1024,ORE:0,FE:0,NE:0,TRUNC:0,TX_DROP:0,LOG_DROP:0,
+        //       HMI_DROP:0,HMI_HWM:24/512,HMI_ORE:0,HMI_FE:0,HMI_NE:0,HMI_TX_DROP:0,HMI_FRM_ERR:0,
+        //       HMI_CPS:85,HMI_ACK_ERR:0,HMI_ACK_LOST:0,
+        //       SCN_DROP:0,SCN_HWM:15/256,SCN_ORE:0,SCN_FE:0,SCN_NE:0,SCN_TRUNC:0 (计数自上电累计)
+        // ---------------------------------------------------------
+        case EVENT_LINK_STATS:
+        {
+            USART_Rx_Stats_t rx, hmi, scn;
+            TJC_Ack_Stats_t ack;
+
+            Protocol_Get_Link_Stats(&rx);
+            getRingBuffStats(&hmi);
+            TJC_Get_Ack_Stats(&ack);
+            Scanner_Get_Link_Stats(&scn);
+            Protocol_Reply("CMD:LINK_STATS,RX_DROP:%lu,RX_HWM:%u/%u,ORE:%lu,FE:%lu,NE:%lu,TRUNC:%lu,"
+                           "TX_DROP:%lu,LOG_DROP:%lu,"
+                           "HMI_DROP:%lu,HMI_HWM:%u/%u,HMI_ORE:%lu,HMI_FE:%lu,HMI_NE:%lu,HMI_TX_DROP:%lu,HMI_FRM_ERR:%lu,"
+                           "HMI_CPS:%u,HMI_ACK_ERR:%lu,HMI_ACK_LOST:%lu,"
+                           "SCN_DROP:%lu,SCN_HWM:%u/%u,SCN_ORE:%lu,SCN_FE:%lu,SCN_NE:%lu,SCN_TRUNC:%lu\n",
+                           (unsigned long)rx.dropped, rx.high_water, rx.size,
+                           (unsigned long)rx.overrun, (unsigned long)rx.framing,
+                           (unsigned long)rx.noise, (unsigned long)rx.truncated,
+                           (unsigned long)USART_TX_Get_Dropped(USART_TX_CH_PROTO),
+                           (unsigned long)USART_TX_Get_Dropped(USART_TX_CH_LOG),
+                           (unsigned long)hmi.dropped, hmi.high_water, hmi.size,
+                           (unsigned long)hmi.overrun, (unsigned long)hmi.framing,
+                           (unsigned long)hmi.noise, (unsigned long)TJC_TX_Get_Dropped(),
+                           (unsigned long)TJC_Get_Frame_Errors(),
+                           ack.rate, (unsigned long)ack.err, (unsigned long)ack.lost,
+                           (unsigned long)scn.dropped, scn.high_water, scn.size,
+                           (unsigned long)scn.overrun, (unsigned long)scn.framing,
+                           (unsigned long)scn.noise, (unsigned long)scn.truncated);
+            break;
+        }
+        // ---------------------------------------------------------
+        // 场景 G: 改单 (PC -> STM32)，修正扫错的商品，不用清空重扫
+        // 指令: CMD:CART_REMOVE,ID:6901234567892[,SEQ:19]         删除该商品整行
+        //       CMD:CART_DEC,ID:6901234567892[,QTY:1][,SEQ:20]    数量减 QTY (缺省 1)，减到 0 删除
+        //       CMD:CART_SET,ID:6901234567892,QTY:3[,SEQ:21]      数量改为 QTY，0 即删除
+        //       CMD:CART_VOID,LINE:2[,SEQ:22]                     按行号 (从 1 开始) 删除一行
+        // 回复: CMD:CART_OK,ID:6901234567892,QTY:2,CNT:5,SUM:12.50[,SEQ:x]
+        // ---------------------------------------------------------
+        case EVENT_CART_REMOVE:
+        case EVENT_CART_DEC:
+        case EVENT_CART_SET:
+        case EVENT_CART_VOID:
+            Cart_Edit_Handler(&rx_packet);
+            break;
+
         case EVENT_NONE:
 
             break;
         }
+        break; // 每次只处理一条非扫码指令，让出主循环
     }
 
+    // 扫码枪直连的条码与上位机扫码共用队列
+    Scanner_Poll();
+
+    // 处理本轮收到的扫码
+    Scan_Queue_Flush();
+
     // 主循环空闲任务 (例如 LED 闪烁心跳)
     // Delay(100);
     // Toggle_LED();
 }
 
+// 生成回复中回显的序号字段 (",SEQ:17")，未携带 SEQ 时为空串
+const char *Seq_Field(uint8_t seq_valid, uint32_t seq)
+{
+    static char field[16];
+
+    if (!seq_valid)
+    {
+        return "";
+    }
+    snprintf(field, sizeof(field), ",SEQ:%lu", (unsigned long)seq);
+    return field;
+}
+
+// 同 Seq_Field，热路径用：直接写入应答缓冲区
+static char *Fmt_Seq_Field(char *p, uint8_t seq_valid, uint32_t seq)
+{
+    if (seq_valid)
+    {
+        p = Fmt_Str(p, ",SEQ:");
+        p = Fmt_U32(p, seq);
+    }
+    return p;
+}
+
+void Scan_Queue_Push(const ParsedPacket_t *packet)
+{
+    ScanRequest_t *req = &scan_queue[scan_queue_count++];
+
+    req->id = packet->id;
+    req->id_valid = packet->id_valid;
+    req->id_check = packet->id_check;
+    req->seq = packet->seq;
+    req->seq_valid = packet->seq_valid;
+}
+
+// 扫码枪直连的条码入队 (无 SEQ，REPORT 异步上报给上位机)
+void Scan_Queue_Push_Code(const char *code)
+{
+    ScanRequest_t *req = &scan_queue[scan_queue_count++];
+
+    req->id_valid = Parse_U64_Dec(code, &req->id);
+    req->id_check = Barcode_Validate(code, (uint8_t)strlen(code));
+    req->seq = 0;
+    req->seq_valid = 0;
+}
+
+// 取出扫码枪收到的条码：空闲时入队，同步期间提示系统忙；队列满时先处理一批
+void Scanner_Poll(void)
+{
+    char code[SCANNER_CODE_MAX + 1];
+
+    while (Scanner_Get_Code(code, sizeof(code)))
+    {
+        if (SlaveState != SYS_STATE_IDLE)
+        {
+            Protocol_Reply("CMD:ALARM,MSG:System_Busy\n");
+            continue;
+        }
+        if (scan_queue_count >= SCAN_QUEUE_DEPTH)
+        {
+            Scan_Queue_Flush();
+        }
+        Scan_Queue_Push_Code(code);
+    }
+}
+
+// 按到达顺序处理排队的扫码：逐条回复 REPORT/ALARM，购物车调试输出与屏幕刷新每批只做一次
+void Scan_Queue_Flush(void)
+{
+    uint8_t i;
+    uint8_t cart_changed = 0;
+    Product_Item_t result_item;
+    char *p;
+
+    for (i = 0; i < scan_queue_count; i++)
+    {
+        ScanRequest_t *req = &scan_queue[i];
+
+        if (!req->id_valid)
+        {
+            Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:Invalid_ID%s\n", Seq_Field(req->seq_valid, req->seq));
+            continue;
+        }
+        if (req->id_check >= BARCODE_BAD_FORMAT)
+        {
+            // 误读条码：不查 Flash，直接报警
+            Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:%s%s\n", Barcode_Alarm_Msg((Barcode_Result_t)req->id_check),
+                           Seq_Field(req->seq_valid, req->seq));
+            continue;
+        }
+
+        // [核心操作] 在 Flash 中查找 ID
+        if (Product_Find_By_ID(req->id, &result_item))
+        {
+            // 找到商品 -> 上报销售信息
+            // 格式: CMD:REPORT,ID:xxx,PR:xxx[,SEQ:xxx],NM:xxx (NM 放最后，名称中可能有逗号以外的任意字符)
+            // 用 fmt.h 直接拼装，不走 vsnprintf
+            p = Protocol_Reply_Buffer();
+            p = Fmt_Str(p, "CMD:REPORT,ID:");
+            p = Fmt_U64(p, result_item.id);
+            p = Fmt_Str(p, ",PR:");
+            p = Fmt_Price(p, result_item.price, 0);
+            p = Fmt_Seq_Field(p, req->seq_valid, req->seq);
+            p = Fmt_Str(p, ",NM:");
+            p = Fmt_Str(p, result_item.name);
+            *p++ = '\n';
+            Protocol_Reply_Send(p);
+            // 同时添加到购物车
+            if (add_product_to_shopping_car(&result_item, 1))
+            {
+                cart_changed = 1;
+            }
+        }
+        else
+        {
+            // 未找到 -> 报警
+            p = Protocol_Reply_Buffer();
+            p = Fmt_Str(p, "CMD:ALARM,LEVEL:1,MSG:Item_Not_Found");
+            p = Fmt_Seq_Field(p, req->seq_valid, req->seq);
+            *p++ = '\n';
+            Protocol_Reply_Send(p);
+        }
+    }
+    scan_queue_count = 0;
+
+    if (cart_changed)
+    {
+        update_shopping_car_display();
+    }
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t ia = *(const uint64_t *)a;
+    uint64_t ib = *(const uint64_t *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+// 整篮扫码：排序去重后一次遍历数据库查找，一次更新购物车，回复一条汇总 REPORT，屏幕只刷新一次
+// 回复: CMD:REPORT,CNT:5,SUM:12.50,ITEMS:id*数量@单价;...[,MISS:id;id][,FULL:id;id][,BAD:n][,SEQ:x]
+//       CNT/SUM/ITEMS 只统计实际加入购物车的商品，购物车已满没加进去的列在 FULL
+void Scan_Batch_Handler(const ParsedPacket_t *packet)
+{
+    static Product_Item_t items[SCAN_BATCH_MAX]; // 静态分配，避免 1KB 占用栈
+    uint64_t ids[SCAN_BATCH_MAX];
+    uint8_t qty[SCAN_BATCH_MAX];
+    uint8_t found[SCAN_BATCH_MAX];
+    uint8_t added[SCAN_BATCH_MAX];
+    uint8_t unique = 0;
+    uint8_t missing = 0;
+    uint8_t rejected = 0;
+    uint8_t i;
+    int units = 0;
+    uint32_t sum = 0; // 分
+    char *p;
+
+    // 1. 排序后相同条码相邻，合并为 (ID, 数量)
+    memcpy(ids, packet->batch_ids, packet->batch_count * sizeof(uint64_t));
+    qsort(ids, packet->batch_count, sizeof(uint64_t), compare_u64);
+    for (i = 0; i < packet->batch_count; i++)
+    {
+        if (unique > 0 && ids[unique - 1] == ids[i])
+        {
+            qty[unique - 1]++;
+        }
+        else
+        {
+            ids[unique] = ids[i];
+            qty[unique] = 1;
+            unique++;
+        }
+    }
+
+    // 2. 一次遍历数据库
+    Product_Find_Batch(ids, unique, items, found);
+
+    // 3. 更新购物车并输出汇总回复 (整帧拼好后一次入队)
+    for (i = 0; i < unique; i++)
+    {
+        added[i] = found[i] && add_product_to_shopping_car(&items[i], qty[i]);
+        if (added[i])
+        {
+            units += qty[i];
+            sum += items[i].price * qty[i];
+        }
+        else if (found[i])
+        {
+            rejected++;
+        }
+        else
+        {
+            missing++;
+        }
+    }
+    // 最长约 45 + 16 * 37 + 8 + 15 字节，PROTOCOL_REPLY_SIZE 足够
+    p = Protocol_Reply_Buffer();
+    p = Fmt_Str(p, "CMD:REPORT,CNT:");
+    p = Fmt_U32(p, units);
+    p = Fmt_Str(p, ",SUM:");
+    p = Fmt_Price(p, sum, 0);
+    p = Fmt_Str(p, ",ITEMS:");
+    for (i = 0; i < unique; i++)
+    {
+        if (added[i])
+        {
+            p = Fmt_U64(p, ids[i]);
+            *p++ = '*';
+            p = Fmt_U32(p, qty[i]);
+            *p++ = '@';
+            p = Fmt_Price(p, items[i].price, 0);
+            *p++ = ';';
+        }
+    }
+    if (missing > 0)
+    {
+        p = Fmt_Str(p, ",MISS:");
+        for (i = 0; i < unique; i++)
+        {
+            if (!found[i])
+            {
+                p = Fmt_U64(p, ids[i]);
+                *p++ = ';';
+            }
+        }
+    }
+    if (rejected > 0)
+    {
+        p = Fmt_Str(p, ",FULL:");
+        for (i = 0; i < unique; i++)
+        {
+            if (found[i] && !added[i])
+            {
+                p = Fmt_U64(p, ids[i]);
+                *p++ = ';';
+            }
+        }
+    }
+    if (packet->batch_invalid > 0)
+    {
+        p = Fmt_Str(p, ",BAD:");
+        p = Fmt_U32(p, packet->batch_invalid);
+    }
+    p = Fmt_Seq_Field(p, packet->seq_valid, packet->seq);
+    *p++ = '\n';
+    Protocol_Reply_Send(p);
+
+    if (units > 0)
+    {
+        update_shopping_car_display();
+    }
+}
+
+// 改单结果：QTY:0 表示该行已删除，CNT 为剩余行数，SUM 为新的总价
+static void Cart_Edit_Reply(uint64_t id, uint16_t count, const char *seq)
+{
+    Protocol_Reply("CMD:CART_OK,ID:%llu,QTY:%u,CNT:%d,SUM:" PRICE_FMT "%s\n",
+                   (unsigned long long)id, count, Cart_Count(), PRICE_ARGS(Cart_Total()), seq);
+}
+
+// 改单：按条码 (REMOVE/DEC/SET) 或行号 (VOID) 修改购物车，总价按差值调整，屏幕只重发受影响的行
+// 回复: CMD:CART_OK,ID:6901234567892,QTY:1,CNT:5,SUM:12.50[,SEQ:x]
+void Cart_Edit_Handler(const ParsedPacket_t *packet)
+{
+    const char *seq = Seq_Field(packet->seq_valid, packet->seq);
+    const Cart_Line_t *line;
+    uint64_t id;
+    uint32_t count;
+    int index;
+
+    if (packet->event == EVENT_CART_VOID)
+    {
+        index = (packet->line_no >= 1 && packet->line_no <= (uint32_t)Cart_Count()) ? (int)packet->line_no - 1 : -1;
+    }
+    else if (!packet->id_valid)
+    {
+        Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:Invalid_ID%s\n", seq);
+        return;
+    }
+    else
+    {
+        index = Cart_Find(packet->id);
+    }
+    if (index < 0)
+    {
+        Protocol_Reply("CMD:ALARM,LEVEL:1,MSG:Not_In_Cart%s\n", seq);
+        return;
+    }
+
+    // 删除后 index 处变成下一行，先记下条码用于回复
+    line = Cart_Get_Line(index);
+    id = line->id;
+    count = line->count;
+    switch (packet->event)
+    {
+    case EVENT_CART_DEC:
+    {
+        uint32_t n = packet->qty_valid ? packet->qty : 1;
+
+        count = (n >= count) ? 0 : count - n;
+        break;
+    }
+    case EVENT_CART_SET:
+        if (!packet->qty_valid || packet->qty > 0xFFFF)
+        {
+            Protocol_Reply("CMD:ALARM,LEVEL:2,MSG:Invalid_Qty%s\n", seq);
+            return;
+        }
+        count = packet->qty;
+        break;
+    default: // CART_REMOVE / CART_VOID
+        count = 0;
+        break;
+    }
+    set_shopping_car_count(index, (uint16_t)count);
+    Cart_Edit_Reply(id, (uint16_t)count, seq);
+    update_shopping_car_display();
+}
+
+// 触摸改单：选中一行后按减一/加一/删除行，修改方式与 CMD:CART_* 相同，结果异步上报给上位机
+void Screen_Cart_Op_Poll(void)
+{
+    int index;
+    Screen_Cart_Op_t op = Screen_Get_Cart_Op(&index);
+    uint64_t id;
+    uint16_t count;
+
+    if (op == SCREEN_CART_OP_NONE)
+    {
+        return;
+    }
+    id = Cart_Get_Line(index)->id;
+    count = Cart_Get_Line(index)->count;
+    if (op == SCREEN_CART_OP_DEC)
+    {
+        count--;
+    }
+    else if (op == SCREEN_CART_OP_INC)
+    {
+        if (count < 0xFFFF)
+        {
+            count++;
+        }
+    }
+    else
+    {
+        count = 0;
+    }
+    LOG_I("[Shop] Touch edit line %d, count -> %u\r\n", index + 1, count);
+    set_shopping_car_count(index, count);
+    Cart_Edit_Reply(id, count, "");
+    update_shopping_car_display();
+}
+
 void callEmergencyHandler(void)
 {
     // 亮红灯，响蜂鸣器，开门，通知上位机
@@ -369,6 +1005,7 @@ void TIM2_IRQHandler(void)
 
         // 1Hz 节拍（用于主循环非阻塞超时）
         g_tim2_tick_s++;
+        Log_Tick_1Hz();
 
         // 如果当前处于数据同步状态，则跳过传感器更新
         if (ShoppingState == SHOP_STATE_SYNCING)
@@ -381,8 +1018,9 @@ void TIM2_IRQHandler(void)
         sensor_data.temper = DS18B20_GetTemperture();
         sensor_data.humidity = DHT11_GetHumidity();
 
-        printf("[Sensor] Temperature: %.2f C, Humidity: %d %%\r\n", sensor_data.temper, sensor_data.humidity);
-        printf("[State] Current Shopping State: %s\r\n", ShoppingState_name[ShoppingState]);
+        // 二进制日志：中断里不做浮点格式化，由上位机 tools/log_decode.py 还原
+        LOG_BIN(LOG_ID_SENSOR, LOG_F32(sensor_data.temper), sensor_data.humidity);
+        LOG_BIN(LOG_ID_SHOP_STATE, ShoppingState);
     }
 }
 
@@ -392,11 +1030,11 @@ void control_Servo_Door(int open)
     if (open)
     {
         // 打开舵机门
-        printf("Servo Door Opened.\r\n");
+        LOG_I("Servo Door Opened.\r\n");
     }
     else
     {
         // 关闭舵机门
-        printf("Servo Door Closed.\r\n");
+        LOG_I("Servo Door Closed.\r\n");
     }
 }
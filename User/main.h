@@ -1,7 +1,11 @@
 #include "stm32f10x.h"
 #include "bsp_usart_dma.h"
 #include "protocol.h" // 环形缓冲区协议
+#include "log.h"      // 分级调试日志
+#include "fmt.h"      // 热路径整数/价格格式化
+#include "scanner.h"  // 扫码枪直连串口
 #include "products.h" // 商品信息管理模块
+#include "cart.h"     // 购物车 (条码哈希)
 #include "stdbool.h"
 #include "./beep/bsp_beep.h" // 引用蜂鸣器模块
 #include "./led/bsp_led.h"   // 引用LED模块
@@ -57,6 +61,39 @@ void Slave_transtate(SlaveState_t _SlaveState)
 ParsedPacket_t rx_packet;       // 存放协议解析出的数据包
 uint32_t sync_received_cnt = 0; // 已接收到的商品数量计数器，这个变量在每次同步时重置
 uint32_t sync_expect_total = 0; // 上位机告知的预期总数
+uint32_t sync_checksum = PRODUCT_CHECKSUM_INIT; // 已接收商品的运行校验和 (用于断点续传比对)
+
+// ==========================================
+// 扫码队列：支持 PC 连续发送多条 CMD:SCAN (用 SEQ 对应回复)
+// ==========================================
+#define SCAN_QUEUE_DEPTH 8
+typedef struct
+{
+    uint64_t id;
+    uint8_t id_valid;
+    uint8_t id_check;  // Barcode_Result_t
+    uint8_t seq_valid; // 1=携带 SEQ，回复中原样回显
+    uint32_t seq;
+} ScanRequest_t;
+ScanRequest_t scan_queue[SCAN_QUEUE_DEPTH];
+uint8_t scan_queue_count = 0;
+void Scan_Queue_Push(const ParsedPacket_t *packet);
+void Scan_Queue_Push_Code(const char *code);
+void Scanner_Poll(void);
+void Scan_Queue_Flush(void);
+void Scan_Batch_Handler(const ParsedPacket_t *packet);
+void Cart_Edit_Handler(const ParsedPacket_t *packet);
+void Screen_Cart_Op_Poll(void);
+const char *Seq_Field(uint8_t seq_valid, uint32_t seq);
+
+// ==========================================
+// 波特率协商 (CMD:SET_BAUD -> CMD:PING 验证)
+// ==========================================
+#define BAUD_VERIFY_TIMEOUT_S 3    // 切换后等待 PING 的超时 (秒)，超时回退
+uint32_t baud_fallback = 0;        // 试用新波特率期间的回退值，0=未在试用
+uint32_t baud_trial_start_s = 0;   // 开始试用的 TIM2 秒计数
+void Baud_Trial_Check(void);
+uint32_t Get_Tick_Ms(void);
 
 // ==========================================
 // 多模块读取到的数据
@@ -73,66 +110,72 @@ SensorData_t sensor_data = {0.0f, 0.0f}; // 初始化传感器数据
 
 void Setup_USART_Interrupt(void);
 
-MCU_Product_t shopping_car[DATA_BUFFER_VOLUME];
-int total_products2paid = 0;
-float total_price = 0.0f; // 购物车商品总价（与购物车同步维护）
-void refresh_MCU_products_list(void);
+// 购物车见 cart.h：按条码哈希查行，每行只存条码/单价/数量，总价随加购累加 (Cart_Total)
 
-// 根据result_item添加商品到购物车，如果已存在则数量+1，否则添加新商品（需要从flash读取商品信息）
-void add_product_to_shopping_car(Product_Item_t *result_item)
+// 添加 count 件商品到购物车，如果已存在则数量累加，否则追加一行
+// 返回 1=已加入, 0=购物车已满 (行数或单行数量已到上限)，购物车不变
+uint8_t add_product_to_shopping_car(Product_Item_t *result_item, int count)
 {
+    uint8_t is_new;
+    int i = Cart_Add(result_item->id, result_item->price, (uint16_t)count, &is_new);
 
-    int i;
-    int found = 0;
-    for (i = 0; i < total_products2paid; i++)
+    if (i < 0)
     {
-        if (shopping_car[i].product.id == result_item->id)
-        {
-            shopping_car[i].num += 1;
-            total_price += result_item->price;
-            found = 1;
-            break;
-        }
+        LOG_W("Shopping Car Full! Cannot Add More Items.\r\n");
+        return 0; // 购物车已满
     }
-    if (found == 0)
+    if (is_new)
     {
-        // 未找到，添加新种类的商品到购物车
-        if (total_products2paid >= DATA_BUFFER_VOLUME)
-        {
-            printf("Shopping Car Full! Cannot Add More Items.\r\n");
-            return; // 购物车已满
-        }
-        total_products2paid++;
-        // 接下来从flash读取商品信息
-        shopping_car[i].product = *result_item;
-        shopping_car[i].num = 1;
-        total_price += result_item->price;
+        Screen_Cache_Line_Name(i, result_item->name); // 名称只在屏幕缓存里保留
+        Screen_Show_Line(i);                          // 翻到新商品所在页
     }
+    Screen_Mark_Line_Dirty(i); // 只重发这一行
+    return 1;
+}
+
+// 修改购物车第 index 行的数量，改成 0 即删除该行；总价按差值调整，屏幕只重发受影响的行
+void set_shopping_car_count(int index, uint16_t count)
+{
+    if (count == 0)
+    {
+        Cart_Remove(index);
+        Screen_Line_Removed(index); // 后面的行前移一位，重发 index 之后的行
+        return;
+    }
+    Cart_Set_Count(index, count);
+    Screen_Mark_Line_Dirty(index);
 }
 
 void clear_shopping_car(void)
 {
-    total_products2paid = 0;
-    total_price = 0.0f;
+    Cart_Clear();
+    Screen_Mark_All_Dirty(); // 下一帧清空屏幕上的商品行
 }
 
-// 调试：打印购物车内容
+// 调试：打印购物车内容 (名称不在 RAM 中，只打印条码)
 void debug_print_shopping_car(void){
-    printf("---- Shopping Car Dump ----\r\n");
-    for(int i=0; i < total_products2paid; i++){
-        printf("Item %d: ID=%llu, Name=%s, Price=%.2f, Count=%d\r\n", 
+    if (Log_Get_Level() < LOG_LEVEL_DEBUG)
+    {
+        return;
+    }
+    LOG_D("---- Shopping Car Dump ----\r\n");
+    for(int i=0; i < Cart_Count(); i++){
+        const Cart_Line_t *line = Cart_Get_Line(i);
+
+        LOG_D("Item %d: ID=%llu, Price=" PRICE_FMT ", Count=%d\r\n", 
             i+1, 
-            (unsigned long long)shopping_car[i].product.id, 
-            shopping_car[i].product.name, 
-            shopping_car[i].product.price, 
-            shopping_car[i].num);
+            (unsigned long long)line->id, 
+            PRICE_ARGS(line->price), 
+            line->count);
     }
-    printf("---------------------------\r\n");
+    LOG_D("Total: " PRICE_FMT "\r\n", PRICE_ARGS(Cart_Total()));
+    LOG_D("---------------------------\r\n");
 }
 
-// 把购物车数据同步到串口屏显示
-void refresh_MCU_products_list(void)
+// 购物车变化后统一刷新：调试输出 + 同步显示数据 (一批扫码只调用一次)
+// 串口屏由主循环 Screen_Render_Task() 限帧发送，连续扫码只发最终状态
+void update_shopping_car_display(void)
 {
-    // 同步到串口屏显示类
-    Screen_Load_New_Data(shopping_car, total_products2paid);
+    // 调试：打印购物车情况
+    debug_print_shopping_car();
 }
@@ -1,8 +1,114 @@
 #include "products.h"
 #include "./flash/bsp_spi_flash.h" // 引用底层驱动
+#include "log.h"
+#include <stdlib.h>                 // qsort / bsearch
+#include <stddef.h>                 // offsetof
+
+// 增量日志查找结果
+#define DELTA_MISS        0 // 日志中没有该 ID
+#define DELTA_HIT_UPSERT  1 // 最新记录为新增/修改
+#define DELTA_HIT_DELETE  2 // 最新记录为删除
 
 // 内部缓存变量，避免频繁读取元数据
 static uint32_t g_cached_total_count = 0;
+// 元数据缓存 (版本/时间戳/校验和)，用于 HELLO 握手
+static Product_Metadata_t g_cached_meta;
+// 下一条同步进度检查点的写入槽位
+static uint32_t g_sync_progress_slot = 0;
+// 增量日志中已写入的记录数 (下一条记录的写入位置)
+static uint32_t g_delta_count = 0;
+// 当前主表起始地址、主表区写过的最大记录数
+static uint32_t g_db_base = FLASH_ADDR_DB_START;
+static uint32_t g_db_extent = 0;
+// 当前有效元数据所在扇区，0xFFFFFFFF=没有 (数据库已擦除)
+#define META_ADDR_NONE 0xFFFFFFFF
+static uint32_t g_meta_addr = META_ADDR_NONE;
+// 上次整理因商品库已满失败时的日志记录数，日志没有新记录前不再重试
+static uint32_t g_compact_failed_at = 0;
+// 有效商品数 (主表扣除删除标记，再合并增量日志)，新增商品时据此检查容量
+static uint32_t g_live_count = 0;
+
+// 主表第 index 条记录的地址
+#define PRODUCT_ITEM_ADDR(index)  (g_db_base + (index) * ITEM_SIZE)
+// 主表区最多占用的扇区数
+#define PRODUCT_DB_SECTORS        ((PRODUCT_MAX_COUNT + PRODUCT_ITEMS_PER_SECTOR - 1) / PRODUCT_ITEMS_PER_SECTOR)
+
+static void Product_Fill_Item(Product_Item_t *item, uint64_t id, uint32_t price, char *name);
+static uint8_t Product_Item_Valid(Product_Item_t *item);
+static uint32_t Product_Count_Live(uint32_t *hash);
+static uint32_t Product_Scan_Main(uint32_t total, uint32_t id_count, uint32_t *hash);
+static uint8_t Product_Delta_Find(uint64_t target_id, Product_Item_t *out_item);
+static uint8_t Product_Delta_Append(const Product_Item_t *item);
+
+/**
+ * @brief  读取两份元数据，取序号较大的有效一份
+ * @return 有效元数据所在扇区地址，都无效返回 META_ADDR_NONE
+ */
+static uint32_t Product_Read_Metadata(Product_Metadata_t *out_meta)
+{
+    static const uint32_t addrs[2] = {FLASH_ADDR_METADATA, FLASH_ADDR_METADATA_B};
+    Product_Metadata_t meta;
+    uint32_t found = META_ADDR_NONE;
+    uint32_t k;
+
+    for (k = 0; k < 2; k++)
+    {
+        SPI_FLASH_BufferRead((uint8_t *)&meta, addrs[k], sizeof(meta));
+        if (meta.magic != PRODUCT_MAGIC_META)
+        {
+            continue;
+        }
+        // 旧版元数据没有这些字段 (读出为全 1)
+        if (meta.seq == 0xFFFFFFFF)
+        {
+            meta.seq = 0;
+        }
+        if (meta.db_base != FLASH_ADDR_DB_ALT)
+        {
+            meta.db_base = FLASH_ADDR_DB_START;
+        }
+        if (meta.db_extent == 0xFFFFFFFF || meta.db_extent < meta.total_count)
+        {
+            meta.db_extent = meta.total_count;
+        }
+        if (found == META_ADDR_NONE || meta.seq > out_meta->seq)
+        {
+            *out_meta = meta;
+            found = addrs[k];
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief  写入新的元数据：写到当前有效副本之外的那个扇区，写完才算生效
+ * @note   擦除的永远不是唯一有效的那一份，任何时刻掉电都还有一份完整的元数据；
+ *         数据库刚擦除 (没有有效副本) 时扇区 0 已是空白，直接写入，不破坏同步检查点
+ */
+static void Product_Commit_Metadata(Product_Metadata_t *meta)
+{
+    uint32_t addr;
+
+    meta->magic = PRODUCT_MAGIC_META;
+    meta->db_base = g_db_base;
+    meta->db_extent = g_db_extent;
+    if (g_meta_addr == META_ADDR_NONE)
+    {
+        meta->seq = 0;
+        addr = FLASH_ADDR_METADATA;
+    }
+    else
+    {
+        meta->seq = g_cached_meta.seq + 1;
+        addr = (g_meta_addr == FLASH_ADDR_METADATA) ? FLASH_ADDR_METADATA_B : FLASH_ADDR_METADATA;
+        SPI_FLASH_SectorErase(addr);
+    }
+    SPI_FLASH_BufferWrite((uint8_t *)meta, addr, sizeof(*meta));
+
+    g_meta_addr = addr;
+    g_cached_total_count = meta->total_count;
+    g_cached_meta = *meta;
+}
 
 /**
  * @brief  初始化商品管理器
@@ -12,17 +118,66 @@ void Product_Manager_Init(void)
     SPI_FLASH_Init();        // 初始化 SPI Flash (bsp_spi_flash.c)
     // 上电时读取一次元数据，获取当前商品总数
     Product_Metadata_t meta;
-    SPI_FLASH_BufferRead((uint8_t *)&meta, FLASH_ADDR_METADATA, sizeof(meta));
+    g_meta_addr = Product_Read_Metadata(&meta);
 
-    if (meta.magic == PRODUCT_MAGIC_VALID)
+    if (g_meta_addr != META_ADDR_NONE)
     {
         g_cached_total_count = meta.total_count;
-        printf("[Product] DB Init. Total Items: %d\r\n", g_cached_total_count);
+        g_cached_meta = meta;
+        g_db_base = meta.db_base;
+        g_db_extent = meta.db_extent;
+        LOG_I("[Product] DB Init. Total Items: %d, Version: %lu\r\n",
+              g_cached_total_count, (unsigned long)meta.version);
     }
     else
     {
         g_cached_total_count = 0;
-        printf("[Product] DB Empty or Invalid.\r\n");
+        memset(&g_cached_meta, 0, sizeof(g_cached_meta));
+        LOG_W("[Product] DB Empty or Invalid.\r\n");
+
+        // 元数据无效可能是同步被中断，检查是否有可续传的进度
+        Product_Sync_Progress_t progress;
+        if (Product_Load_Sync_Progress(&progress))
+        {
+            LOG_W("[Product] Interrupted Sync Found: %lu/%lu, send CMD:SYNC_RESUME to continue.\r\n",
+                  (unsigned long)progress.received_cnt,
+                  (unsigned long)progress.expect_total);
+        }
+    }
+
+    // 统计增量日志中的记录数：日志顺序追加，遇到空槽即为末尾
+    uint32_t magic;
+    uint8_t hash_at_tail = 1; // 最后一条是版本记录 (或日志为空)：其中的内容校验和是最新的
+    for (g_delta_count = 0; g_delta_count < DELTA_LOG_MAX_ENTRIES; g_delta_count++)
+    {
+        SPI_FLASH_BufferRead((uint8_t *)&magic,
+                             FLASH_ADDR_DELTA_LOG + g_delta_count * ITEM_SIZE + offsetof(Product_Item_t, magic),
+                             sizeof(magic));
+        if (magic == PRODUCT_MAGIC_EMPTY)
+        {
+            break;
+        }
+        hash_at_tail = 0;
+        if (magic == PRODUCT_MAGIC_VERSION)
+        {
+            // 增量更新后的版本号和内容校验和比元数据中的新
+            Product_Item_t rec;
+            SPI_FLASH_BufferRead((uint8_t *)&rec, FLASH_ADDR_DELTA_LOG + g_delta_count * ITEM_SIZE, ITEM_SIZE);
+            g_cached_meta.version = (uint32_t)rec.id;
+            g_cached_meta.content_hash = rec.price;
+            hash_at_tail = 1;
+        }
+    }
+    if (g_delta_count > 0)
+    {
+        LOG_I("[Product] Delta Log: %lu records pending.\r\n", (unsigned long)g_delta_count);
+    }
+    // 有效商品数不落盘，上电遍历一次；商品记录之后没来得及写版本记录就掉电时，校验和也用遍历结果
+    uint32_t hash;
+    g_live_count = Product_Count_Live(&hash);
+    if (!hash_at_tail)
+    {
+        g_cached_meta.content_hash = hash;
     }
 
     printf("\r\n");
@@ -37,79 +192,627 @@ void Product_Manager_Init(void)
 
 /**
  * @brief  清空/格式化数据库 (用于同步开始时)
+ * @param  expect_total: 本次同步的商品数，擦除范围至少覆盖这么多条
  */
-void Product_Clear_Database(void)
+void Product_Clear_Database(uint32_t expect_total)
 {
-    printf("[Product] Erasing Database...\r\n");
-    // 1. 擦除元数据区 (Sector 0)
+    uint32_t sectors;
+    uint32_t i;
+
+    LOG_I("[Product] Erasing Database...\r\n");
+    // 1. 擦除两份元数据 (扇区 0 同时存放同步检查点)
     SPI_FLASH_SectorErase(FLASH_ADDR_METADATA);
+    SPI_FLASH_SectorErase(FLASH_ADDR_METADATA_B);
+    g_meta_addr = META_ADDR_NONE;
 
-    // 2. 擦除数据区
-    // 根据实际情况，擦除足够的扇区。W25Q64 一个扇区 4KB，存 64字节商品可存 64个。
-    // 假设最大 5000 个商品 -> 5000 * 64 = 320,000 字节 ≈ 312 KB ≈ 79 个扇区
-    // 这里简单演示循环擦除前 10 个扇区，实际建议根据 g_cached_total_count 动态计算
-    uint32_t i;
-    for (i = 0; i < 20; i++)
+    // 2. 擦除数据区：W25Q64 一个扇区 4KB，存 64 条商品。
+    // 覆盖本次要写入的范围和主表区用过的全部扇区 (增量整理会让主表变长)，不留旧数据。
+    // 全量同步固定写主区 (断电续传时元数据已擦除，只能按默认位置续写)；
+    // 之前整理搬到了备用区时，主区用到哪里已无记录，整区擦除
+    if (expect_total > PRODUCT_MAX_COUNT)
+    {
+        expect_total = PRODUCT_MAX_COUNT;
+    }
+    if (g_db_base != FLASH_ADDR_DB_START)
+    {
+        g_db_base = FLASH_ADDR_DB_START;
+        g_db_extent = PRODUCT_MAX_COUNT;
+    }
+    if (g_db_extent < expect_total)
     {
-        SPI_FLASH_SectorErase(FLASH_ADDR_DB_START + (i * 4096)); // 4096 is Sector Size
+        g_db_extent = expect_total;
     }
+    sectors = (g_db_extent + PRODUCT_ITEMS_PER_SECTOR - 1) / PRODUCT_ITEMS_PER_SECTOR;
+    if (sectors > PRODUCT_DB_SECTORS)
+    {
+        sectors = PRODUCT_DB_SECTORS;
+    }
+    for (i = 0; i < sectors; i++)
+    {
+        SPI_FLASH_SectorErase(g_db_base + (i * 4096)); // 4096 is Sector Size
+    }
+    g_db_extent = expect_total;
+
+    // 3. 全量同步会覆盖所有增量修改，日志一并清空
+    for (i = 0; i < DELTA_LOG_SECTORS; i++)
+    {
+        SPI_FLASH_SectorErase(FLASH_ADDR_DELTA_LOG + (i * 4096));
+    }
+    g_delta_count = 0;
 
     g_cached_total_count = 0;
-    printf("[Product] Erase Done.\r\n");
+    g_cached_meta.content_hash = 0;
+    g_live_count = 0;
+    g_sync_progress_slot = 0; // 扇区 0 已擦除，检查点从头开始写
+    LOG_I("[Product] Erase Done.\r\n");
 }
 
 /**
  * @brief  更新商品总数 (用于同步结束时)
+ * @note   内容校验和遍历一次刚写入的主表计算 (断点续传时 RAM 中没有完整的累加值)
  */
-void Product_Update_Metadata(uint32_t count)
+void Product_Update_Metadata(uint32_t count, uint32_t version, uint32_t timestamp)
 {
     Product_Metadata_t meta;
     meta.total_count = count;
-    meta.version = 0x0100;
-    meta.magic = PRODUCT_MAGIC_VALID;
+    meta.update_timestamp = timestamp;
+    meta.version = version;
+    meta.content_hash = 0;
+
+    if (g_db_extent < count)
+    {
+        g_db_extent = count;
+    }
+    g_live_count = Product_Scan_Main(count, 0, &meta.content_hash);
+    Product_Commit_Metadata(&meta);
+    LOG_I("[Product] Metadata Updated. Total: %d, Version: %lu\r\n", count, (unsigned long)version);
+}
+
+/**
+ * @brief  获取当前元数据 (RAM 缓存)
+ */
+void Product_Get_Metadata(Product_Metadata_t *out_meta)
+{
+    *out_meta = g_cached_meta;
+    out_meta->total_count = g_cached_total_count;
+}
+
+/**
+ * @brief  更新同步运行校验和 (FNV-1a)
+ * @note   上位机按相同顺序计算即可比对：ID 8 字节小端、价格 (分) 4 字节小端、名称字节
+ */
+uint32_t Product_Checksum_Update(uint32_t sum, uint64_t id, uint32_t price, const char *name)
+{
+    uint8_t buf[12];
+    uint32_t i;
+
+    memcpy(buf, &id, 8);
+    memcpy(buf + 8, &price, 4);
+    for (i = 0; i < sizeof(buf); i++)
+    {
+        sum = (sum ^ buf[i]) * 0x01000193;
+    }
+    while (*name != '\0')
+    {
+        sum = (sum ^ (uint8_t)*name++) * 0x01000193;
+    }
+    return sum;
+}
+
+/**
+ * @brief  单个商品的内容哈希
+ * @note   商品库内容校验和 = 所有有效商品的 Product_Item_Hash 之和 (mod 2^32)，空库为 0；
+ *         与存储顺序无关，增删改时按差值更新
+ */
+uint32_t Product_Item_Hash(uint64_t id, uint32_t price, const char *name)
+{
+    return Product_Checksum_Update(PRODUCT_CHECKSUM_INIT, id, price, name);
+}
+
+/**
+ * @brief  追加保存同步进度检查点
+ * @note   检查点只记录已连续写入的数量，续传时从该位置重发；
+ *         检查点之后、掉电之前写入的商品会被重写同样的数据，对 NOR Flash 无副作用
+ */
+void Product_Save_Sync_Progress(uint32_t expect_total, uint32_t received_cnt, uint32_t checksum)
+{
+    Product_Sync_Progress_t progress;
+
+    if (g_sync_progress_slot >= SYNC_PROGRESS_SLOT_COUNT)
+    {
+        // 槽位用完：后续中断只能从最后一个检查点续传
+        return;
+    }
+
+    progress.expect_total = expect_total;
+    progress.received_cnt = received_cnt;
+    progress.checksum = checksum;
+    progress.magic = PRODUCT_MAGIC_SYNC;
+
+    SPI_FLASH_BufferWrite((uint8_t *)&progress,
+                          FLASH_ADDR_SYNC_PROGRESS + g_sync_progress_slot * sizeof(progress),
+                          sizeof(progress));
+    g_sync_progress_slot++;
+}
+
+/**
+ * @brief  读取最近一次被中断的同步进度
+ * @return 1=存在可续传的进度, 0=无 (元数据有效说明上次同步已完成)
+ */
+uint8_t Product_Load_Sync_Progress(Product_Sync_Progress_t *out_progress)
+{
+    Product_Metadata_t meta;
+    Product_Sync_Progress_t progress;
+    uint32_t slot;
+    uint8_t found = 0;
+
+    if (Product_Read_Metadata(&meta) != META_ADDR_NONE)
+    {
+        return 0;
+    }
+
+    // 顺序扫描检查点，遇到空槽即停止，最后一条有效记录就是最新进度
+    for (slot = 0; slot < SYNC_PROGRESS_SLOT_COUNT; slot++)
+    {
+        SPI_FLASH_BufferRead((uint8_t *)&progress,
+                             FLASH_ADDR_SYNC_PROGRESS + slot * sizeof(progress),
+                             sizeof(progress));
+        if (progress.magic != PRODUCT_MAGIC_SYNC)
+        {
+            break;
+        }
+        *out_progress = progress;
+        found = 1;
+    }
 
-    // 写入 Sector 0
-    SPI_FLASH_BufferWrite((uint8_t *)&meta, FLASH_ADDR_METADATA, sizeof(meta));
-    g_cached_total_count = count;
-    printf("[Product] Metadata Updated. Total: %d\r\n", count);
+    // 续传后新的检查点接着写在后面
+    g_sync_progress_slot = slot;
+    return found;
 }
 
 /**
  * @brief  写入单个商品
  * @param  index: 存储序号 (0, 1, 2...)
  */
-void Product_Write_Item(uint32_t index, uint64_t id, float price, char *name)
+void Product_Write_Item(uint32_t index, uint64_t id, uint32_t price, char *name)
 {
     Product_Item_t item;
 
     // 1. 填充结构体
-    item.id = id;
-    item.price = price;
-    item.magic = PRODUCT_MAGIC_VALID;
-
-    memset(item.name, 0, sizeof(item.name));
-    strncpy(item.name, name, sizeof(item.name) - 1);
+    Product_Fill_Item(&item, id, price, name);
 
     // 2. 计算地址
-    uint32_t write_addr = FLASH_ADDR_DB_START + (index * ITEM_SIZE);
+    uint32_t write_addr = PRODUCT_ITEM_ADDR(index);
 
     // 3. 写入 Flash
     SPI_FLASH_BufferWrite((uint8_t *)&item, write_addr, ITEM_SIZE);
 }
 
+/**
+ * @brief  填充商品结构体 (名称截断并补 0)
+ */
+static void Product_Fill_Item(Product_Item_t *item, uint64_t id, uint32_t price, char *name)
+{
+    item->id = id;
+    item->price = price;
+    item->magic = PRODUCT_MAGIC_VALID;
+
+    memset(item->name, 0, sizeof(item->name));
+    strncpy(item->name, name, sizeof(item->name) - 1);
+}
+
+/**
+ * @brief  判断记录是否为有效商品，V1 (float 价格) 记录就地换算成分
+ * @note   旧固件同步的数据无需重新同步即可使用；整理时写回主表的是 V2 记录
+ * @return 1=有效商品, 0=删除/空/损坏
+ */
+static uint8_t Product_Item_Valid(Product_Item_t *item)
+{
+    if (item->magic == PRODUCT_MAGIC_VALID)
+    {
+        return 1;
+    }
+    if (item->magic == PRODUCT_MAGIC_VALID_V1)
+    {
+        float legacy;
+        memcpy(&legacy, &item->price, sizeof(legacy));
+        item->price = (legacy > 0.0f) ? (uint32_t)(legacy * 100.0f + 0.5f) : 0;
+        item->magic = PRODUCT_MAGIC_VALID;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  增量新增/修改商品
+ * @note   只追加一条日志记录 (一次页编程，毫秒级)，不擦除主表；
+ *         新增商品前检查容量，保证日志总能整理回主表
+ */
+uint8_t Product_Upsert(uint64_t id, uint32_t price, char *name)
+{
+    Product_Item_t item;
+    uint8_t exists = Product_Find_By_ID(id, &item);
+
+    if (!exists && g_live_count >= PRODUCT_MAX_COUNT)
+    {
+        LOG_E("[Product] DB Full! ID:%llu Rejected.\r\n", (unsigned long long)id);
+        return 0;
+    }
+
+    uint32_t hash = g_cached_meta.content_hash;
+    if (exists)
+    {
+        hash -= Product_Item_Hash(item.id, item.price, item.name);
+    }
+    Product_Fill_Item(&item, id, price, name);
+    if (!Product_Delta_Append(&item))
+    {
+        return 0;
+    }
+    if (!exists)
+    {
+        g_live_count++;
+    }
+    g_cached_meta.content_hash = hash + Product_Item_Hash(item.id, item.price, item.name);
+    return 1;
+}
+
+/**
+ * @brief  增量删除商品
+ * @return 1=成功, 0=商品不存在或日志已满
+ */
+uint8_t Product_Delete(uint64_t id)
+{
+    Product_Item_t item;
+
+    if (!Product_Find_By_ID(id, &item))
+    {
+        return 0;
+    }
+    uint32_t hash = g_cached_meta.content_hash - Product_Item_Hash(item.id, item.price, item.name);
+
+    // 删除记录：保留 ID，magic 写 PRODUCT_MAGIC_DELETED
+    memset(&item, 0, sizeof(item));
+    item.id = id;
+    item.magic = PRODUCT_MAGIC_DELETED;
+    if (!Product_Delta_Append(&item))
+    {
+        return 0;
+    }
+    g_live_count--;
+    g_cached_meta.content_hash = hash;
+    return 1;
+}
+
+/**
+ * @brief  增量更新后设置商品库版本
+ * @note   版本记录与商品记录写在同一日志中，price 字段同时保存当前内容校验和，
+ *         复位后由 Product_Manager_Init 恢复。每次增删改之后都要写一条 (版本号不变也写)
+ */
+void Product_Set_Version(uint32_t version)
+{
+    Product_Item_t item;
+
+    memset(&item, 0, sizeof(item));
+    item.id = version;
+    item.price = g_cached_meta.content_hash;
+    item.magic = PRODUCT_MAGIC_VERSION;
+    if (Product_Delta_Append(&item))
+    {
+        g_cached_meta.version = version;
+    }
+}
+
+/**
+ * @brief  获取增量日志中的记录数
+ */
+uint32_t Product_Delta_Count(void)
+{
+    return g_delta_count;
+}
+
+/**
+ * @brief  追加一条增量日志记录，日志已满时先整理
+ * @return 1=成功, 0=日志已满且无法整理 (商品库已满)
+ */
+static uint8_t Product_Delta_Append(const Product_Item_t *item)
+{
+    if (g_delta_count >= DELTA_LOG_MAX_ENTRIES && !Product_Delta_Compact())
+    {
+        LOG_E("[Product] Delta Log Full and DB Full, Change Rejected.\r\n");
+        return 0;
+    }
+
+    SPI_FLASH_BufferWrite((uint8_t *)item, FLASH_ADDR_DELTA_LOG + g_delta_count * ITEM_SIZE, ITEM_SIZE);
+    g_delta_count++;
+    return 1;
+}
+
+/**
+ * @brief  在增量日志中查找 ID (从新到旧，最新一条记录生效)
+ * @return DELTA_MISS / DELTA_HIT_UPSERT / DELTA_HIT_DELETE
+ */
+static uint8_t Product_Delta_Find(uint64_t target_id, Product_Item_t *out_item)
+{
+    uint32_t i = g_delta_count;
+
+    while (i > 0)
+    {
+        i--;
+        uint32_t addr = FLASH_ADDR_DELTA_LOG + (i * ITEM_SIZE);
+        uint64_t read_id;
+        SPI_FLASH_BufferRead((uint8_t *)&read_id, addr, 8);
+
+        if (read_id != target_id)
+        {
+            continue;
+        }
+
+        SPI_FLASH_BufferRead((uint8_t *)out_item, addr, ITEM_SIZE);
+        if (Product_Item_Valid(out_item))
+        {
+            return DELTA_HIT_UPSERT;
+        }
+        if (out_item->magic == PRODUCT_MAGIC_DELETED)
+        {
+            return DELTA_HIT_DELETE;
+        }
+        // 写入中途掉电的坏记录：忽略，继续找更旧的记录
+    }
+    return DELTA_MISS;
+}
+
+static int Product_Compare_ID(const void *a, const void *b)
+{
+    uint64_t ia = *(const uint64_t *)a;
+    uint64_t ib = *(const uint64_t *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+// 整理用：日志中出现过的 ID (去重后升序) 及其在合并时是否已写入，静态分配避免占用栈
+static uint64_t s_delta_ids[DELTA_LOG_MAX_ENTRIES];
+static uint8_t s_delta_done[DELTA_LOG_MAX_ENTRIES];
+
+/**
+ * @brief  收集日志中出现过的 ID (去重后排序)
+ * @param  upserts: 输出最新记录为新增/修改的 ID 数 (整理后要追加到主表的条数)
+ * @param  hash: 累加这些新增/修改商品的 Product_Item_Hash
+ * @return 不同 ID 的个数
+ */
+static uint32_t Product_Delta_Collect(uint32_t *upserts, uint32_t *hash)
+{
+    Product_Item_t item;
+    uint32_t id_count = 0;
+    uint32_t i, j;
+
+    *upserts = 0;
+    // 从新到旧遍历日志，每个 ID 第一次出现的记录即为最新
+    i = g_delta_count;
+    while (i > 0)
+    {
+        i--;
+        SPI_FLASH_BufferRead((uint8_t *)&item, FLASH_ADDR_DELTA_LOG + (i * ITEM_SIZE), ITEM_SIZE);
+        if (!Product_Item_Valid(&item) && item.magic != PRODUCT_MAGIC_DELETED)
+        {
+            continue;
+        }
+        for (j = 0; j < id_count; j++)
+        {
+            if (s_delta_ids[j] == item.id)
+            {
+                break;
+            }
+        }
+        if (j < id_count)
+        {
+            continue; // 已被更新的记录覆盖
+        }
+        s_delta_ids[id_count++] = item.id;
+        if (item.magic == PRODUCT_MAGIC_VALID)
+        {
+            (*upserts)++;
+            *hash += Product_Item_Hash(item.id, item.price, item.name);
+        }
+    }
+    qsort(s_delta_ids, id_count, sizeof(uint64_t), Product_Compare_ID);
+    memset(s_delta_done, 0, id_count);
+    return id_count;
+}
+
+/**
+ * @brief  在 base 区第 index 条写入商品，进入新扇区时先擦除
+ * @note   写入位置之后的扇区可能残留旧数据；扇区内写入位置之后的部分已在进入该扇区时擦除
+ */
+static void Product_Put_Item(uint32_t base, uint32_t index, const Product_Item_t *item)
+{
+    uint32_t addr = base + (index * ITEM_SIZE);
+
+    if (addr % 4096 == 0)
+    {
+        SPI_FLASH_SectorErase(addr);
+    }
+    SPI_FLASH_BufferWrite((uint8_t *)item, addr, ITEM_SIZE);
+}
+
+/**
+ * @brief  把日志中每个 ID 最新的新增/修改记录写到 base 区第 index 条起
+ * @return 写完后的记录数
+ */
+static uint32_t Product_Delta_Write_Upserts(uint32_t base, uint32_t index, uint32_t id_count)
+{
+    Product_Item_t item;
+    uint32_t i = g_delta_count;
+
+    while (i > 0)
+    {
+        i--;
+        SPI_FLASH_BufferRead((uint8_t *)&item, FLASH_ADDR_DELTA_LOG + (i * ITEM_SIZE), ITEM_SIZE);
+        if (!Product_Item_Valid(&item) && item.magic != PRODUCT_MAGIC_DELETED)
+        {
+            continue;
+        }
+        uint64_t *hit = bsearch(&item.id, s_delta_ids, id_count, sizeof(uint64_t), Product_Compare_ID);
+        if (hit == NULL || s_delta_done[hit - s_delta_ids])
+        {
+            continue;
+        }
+        s_delta_done[hit - s_delta_ids] = 1;
+        if (item.magic == PRODUCT_MAGIC_VALID)
+        {
+            Product_Put_Item(base, index++, &item);
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief  统计主表前 total 条中未被日志覆盖的有效商品数，并累加其 Product_Item_Hash
+ * @note   id_count 为 Product_Delta_Collect 的返回值 (传 0 表示不排除)，遍历一次主表
+ */
+static uint32_t Product_Scan_Main(uint32_t total, uint32_t id_count, uint32_t *hash)
+{
+    Product_Item_t item;
+    uint32_t live = 0;
+    uint32_t i;
+
+    for (i = 0; i < total; i++)
+    {
+        if (Product_Read_ByIndex(i, &item) &&
+            bsearch(&item.id, s_delta_ids, id_count, sizeof(uint64_t), Product_Compare_ID) == NULL)
+        {
+            live++;
+            *hash += Product_Item_Hash(item.id, item.price, item.name);
+        }
+    }
+    return live;
+}
+
+/**
+ * @brief  统计有效商品数和内容校验和 (上电时调用一次，之后增量维护)
+ */
+static uint32_t Product_Count_Live(uint32_t *hash)
+{
+    uint32_t upserts;
+    uint32_t id_count;
+
+    *hash = 0;
+    id_count = Product_Delta_Collect(&upserts, hash);
+    return Product_Scan_Main(g_cached_total_count, id_count, hash) + upserts;
+}
+
+/**
+ * @brief  整理：把增量日志合并回主表，然后擦除日志
+ * @note   先确认放得下再动 Flash，放不下时日志原样保留、变更不会丢失：
+ *         1. 主表末尾还有空间：新增/修改追加到末尾，被日志覆盖的旧记录原位写删除标记 (只把 1 写成 0)
+ *         2. 空间不够 (删除标记占满)：有效商品和日志合并后重写到另一个主表区，回收删除标记
+ *         3. 重新统计有效商品数和内容校验和，写入新的元数据 (另一个扇区，写完才生效)，最后擦除日志
+ *         写入新元数据之前掉电，日志仍然完整且查找优先查日志，重新整理即可恢复
+ * @return 1=完成, 0=有效商品超过 PRODUCT_MAX_COUNT，放弃整理
+ */
+uint8_t Product_Delta_Compact(void)
+{
+    Product_Item_t item;
+    Product_Metadata_t meta;
+    uint32_t old_total = g_cached_total_count;
+    uint32_t new_total;
+    uint32_t id_count, upserts;
+    uint32_t hash = 0; // 整理时不用，最后按合并后的主表重新计算
+    uint32_t i;
+
+    if (g_delta_count == 0)
+    {
+        return 1;
+    }
+    if (g_delta_count == g_compact_failed_at)
+    {
+        return 0; // 上次已确认放不下，日志没有变化
+    }
+    LOG_I("[Product] Compacting %lu Delta Records...\r\n", (unsigned long)g_delta_count);
+
+    id_count = Product_Delta_Collect(&upserts, &hash);
+
+    if (old_total + upserts <= PRODUCT_MAX_COUNT)
+    {
+        // 1. 追加到主表末尾，再单次遍历旧主表，被日志覆盖的记录写删除标记
+        new_total = Product_Delta_Write_Upserts(g_db_base, old_total, id_count);
+        for (i = 0; i < old_total; i++)
+        {
+            uint32_t addr = PRODUCT_ITEM_ADDR(i);
+            uint64_t read_id;
+            SPI_FLASH_BufferRead((uint8_t *)&read_id, addr, 8);
+
+            if (bsearch(&read_id, s_delta_ids, id_count, sizeof(uint64_t), Product_Compare_ID) != NULL)
+            {
+                uint32_t deleted = PRODUCT_MAGIC_DELETED;
+                SPI_FLASH_BufferWrite((uint8_t *)&deleted, addr + offsetof(Product_Item_t, magic), sizeof(deleted));
+            }
+        }
+    }
+    else
+    {
+        // 2. 先数一遍留下的商品，确认重写后放得下
+        uint32_t alt = (g_db_base == FLASH_ADDR_DB_START) ? FLASH_ADDR_DB_ALT : FLASH_ADDR_DB_START;
+        uint32_t live = Product_Scan_Main(old_total, id_count, &hash) + upserts;
+
+        if (live > PRODUCT_MAX_COUNT)
+        {
+            g_compact_failed_at = g_delta_count;
+            LOG_E("[Product] DB Full! %lu Items after Compaction, Delta Log Kept.\r\n", (unsigned long)live);
+            return 0;
+        }
+
+        // 旧区保持不动，新元数据写入前掉电仍以旧区为准
+        new_total = 0;
+        for (i = 0; i < old_total; i++)
+        {
+            if (Product_Read_ByIndex(i, &item) &&
+                bsearch(&item.id, s_delta_ids, id_count, sizeof(uint64_t), Product_Compare_ID) == NULL)
+            {
+                Product_Put_Item(alt, new_total++, &item);
+            }
+        }
+        new_total = Product_Delta_Write_Upserts(alt, new_total, id_count);
+        g_db_base = alt;
+        g_db_extent = 0;
+        LOG_I("[Product] DB Rewritten to 0x%06lX.\r\n", (unsigned long)alt);
+    }
+    if (g_db_extent < new_total)
+    {
+        g_db_extent = new_total;
+    }
+
+    // 3. 按合并后的主表重新计算有效商品数和内容校验和 (与顺序无关，应与整理前相同)
+    meta = g_cached_meta;
+    meta.total_count = new_total;
+    meta.content_hash = 0;
+    g_live_count = Product_Scan_Main(new_total, 0, &meta.content_hash);
+    Product_Commit_Metadata(&meta);
+
+    // 4. 擦除日志
+    for (i = 0; i < DELTA_LOG_SECTORS; i++)
+    {
+        SPI_FLASH_SectorErase(FLASH_ADDR_DELTA_LOG + (i * 4096));
+    }
+    g_delta_count = 0;
+    g_compact_failed_at = 0;
+
+    LOG_I("[Product] Compact Done. Total: %lu\r\n", (unsigned long)new_total);
+    return 1;
+}
+
 /**
  * @brief  根据索引读取商品
  * @return 1=成功, 0=无效数据
  */
 uint8_t Product_Read_ByIndex(uint32_t index, Product_Item_t *out_item)
 {
-    uint32_t addr = FLASH_ADDR_DB_START + (index * ITEM_SIZE);
+    uint32_t addr = PRODUCT_ITEM_ADDR(index);
 
     // 读取
     SPI_FLASH_BufferRead((uint8_t *)out_item, addr, ITEM_SIZE);
 
     // 校验
-    if (out_item->magic == PRODUCT_MAGIC_VALID)
+    if (Product_Item_Valid(out_item))
     {
         return 1;
     }
@@ -126,6 +829,17 @@ uint8_t Product_Find_By_ID(uint64_t target_id, Product_Item_t *out_item)
 {
     uint32_t i;
 
+    // 增量日志中的记录比主表新，优先生效
+    switch (Product_Delta_Find(target_id, out_item))
+    {
+    case DELTA_HIT_UPSERT:
+        return 1;
+    case DELTA_HIT_DELETE:
+        return 0;
+    default:
+        break;
+    }
+
     // 如果数据库为空，直接返回
     if (g_cached_total_count == 0)
         return 0;
@@ -134,7 +848,7 @@ uint8_t Product_Find_By_ID(uint64_t target_id, Product_Item_t *out_item)
     for (i = 0; i < g_cached_total_count; i++)
     {
         // 计算地址
-        uint32_t addr = FLASH_ADDR_DB_START + (i * ITEM_SIZE);
+        uint32_t addr = PRODUCT_ITEM_ADDR(i);
 
         // 优化：先只读前 4 个字节 (ID)，如果匹配再读剩下的
         // 这样比每次读 64 字节快很多
@@ -147,7 +861,7 @@ uint8_t Product_Find_By_ID(uint64_t target_id, Product_Item_t *out_item)
             SPI_FLASH_BufferRead((uint8_t *)out_item, addr, ITEM_SIZE);
 
             // 二次确认 magic (防止读到坏数据)
-            if (out_item->magic == PRODUCT_MAGIC_VALID)
+            if (Product_Item_Valid(out_item))
             {
                 return 1; // 找到了
             }
@@ -157,6 +871,82 @@ uint8_t Product_Find_By_ID(uint64_t target_id, Product_Item_t *out_item)
     return 0; // 遍历完都没找到
 }
 
+/**
+ * @brief  批量查找
+ * @note   逐个调用 Product_Find_By_ID 需要遍历 count 次；这里对每条 Flash 记录
+ *         在有序 ID 表中二分查找，日志和主表各只遍历一次，全部找到即提前退出
+ */
+uint8_t Product_Find_Batch(const uint64_t *sorted_ids, uint8_t count, Product_Item_t *out_items, uint8_t *found)
+{
+    // found[] 内部状态：0=未定, 1=找到, 2=日志中已删除 (最后转换为 0)
+    uint8_t resolved = 0;
+    uint8_t found_cnt = 0;
+    uint32_t i;
+    uint8_t k;
+
+    memset(found, 0, count);
+
+    // 1. 增量日志 (从新到旧，每个 ID 以最新记录为准)
+    i = g_delta_count;
+    while (i > 0 && resolved < count)
+    {
+        i--;
+        uint32_t addr = FLASH_ADDR_DELTA_LOG + (i * ITEM_SIZE);
+        uint64_t read_id;
+        SPI_FLASH_BufferRead((uint8_t *)&read_id, addr, 8);
+
+        const uint64_t *hit = bsearch(&read_id, sorted_ids, count, sizeof(uint64_t), Product_Compare_ID);
+        if (hit == NULL || found[hit - sorted_ids] != 0)
+        {
+            continue;
+        }
+        k = hit - sorted_ids;
+        SPI_FLASH_BufferRead((uint8_t *)&out_items[k], addr, ITEM_SIZE);
+        if (Product_Item_Valid(&out_items[k]))
+        {
+            found[k] = 1;
+            found_cnt++;
+            resolved++;
+        }
+        else if (out_items[k].magic == PRODUCT_MAGIC_DELETED)
+        {
+            found[k] = 2;
+            resolved++;
+        }
+    }
+
+    // 2. 主表
+    for (i = 0; i < g_cached_total_count && resolved < count; i++)
+    {
+        uint32_t addr = PRODUCT_ITEM_ADDR(i);
+        uint64_t read_id;
+        SPI_FLASH_BufferRead((uint8_t *)&read_id, addr, 8);
+
+        const uint64_t *hit = bsearch(&read_id, sorted_ids, count, sizeof(uint64_t), Product_Compare_ID);
+        if (hit == NULL || found[hit - sorted_ids] != 0)
+        {
+            continue;
+        }
+        k = hit - sorted_ids;
+        SPI_FLASH_BufferRead((uint8_t *)&out_items[k], addr, ITEM_SIZE);
+        if (Product_Item_Valid(&out_items[k]))
+        {
+            found[k] = 1;
+            found_cnt++;
+            resolved++;
+        }
+    }
+
+    for (k = 0; k < count; k++)
+    {
+        if (found[k] != 1)
+        {
+            found[k] = 0;
+        }
+    }
+    return found_cnt;
+}
+
 void Product_Get_All_Info(Product_Item_t* list, int totalItems)
 {
     Product_Item_t item;
@@ -186,7 +976,12 @@ void Product_Debug_Dump_All(void)
     Product_Item_t item;
     uint32_t i;
 
-    printf("\r\n--- Product Dump ---\r\n");
+    // 日志等级不到 DEBUG 时不必逐条读 Flash
+    if (Log_Get_Level() < LOG_LEVEL_DEBUG)
+    {
+        return;
+    }
+    LOG_D("\r\n--- Product Dump ---\r\n");
 
     // 使用 cached_count 避免读取空数据
     uint32_t limit = (g_cached_total_count > 0) ? g_cached_total_count : 100;
@@ -195,11 +990,11 @@ void Product_Debug_Dump_All(void)
     {
         if (Product_Read_ByIndex(i, &item))
         {
-            printf("[%d] ID:%llu, Price:%.2f, Name:%s\r\n",
-                   i,
-                   (unsigned long long)item.id,
-                   item.price,
-                   item.name);
+            LOG_D("[%d] ID:%llu, Price:" PRICE_FMT ", Name:%s\r\n",
+                  i,
+                  (unsigned long long)item.id,
+                  PRICE_ARGS(item.price),
+                  item.name);
         }
         else
         {
@@ -208,5 +1003,5 @@ void Product_Debug_Dump_All(void)
                 break;
         }
     }
-    printf("--- End ---\r\n");
+    LOG_D("--- End ---\r\n");
 }
@@ -10,18 +10,45 @@
 // 1. 配置与内存映射
 // ==========================================
 // 有效标记 (用于判断 Flash 该位置是否有数据)
-#define PRODUCT_MAGIC_VALID     0xA5A5A5A5
+#define PRODUCT_MAGIC_META      0xA5A5A5A5  // 元数据有效
+#define PRODUCT_MAGIC_VALID     0xA5A50200  // 商品记录 V2：价格为整数 (分)
+#define PRODUCT_MAGIC_VALID_V1  0xA5A5A5A5  // 商品记录 V1：价格为 float (旧数据，读出时换算成分)
 #define PRODUCT_MAGIC_EMPTY     0xFFFFFFFF 
+#define PRODUCT_MAGIC_DELETED   0x00000000  // 删除标记 (可直接在原位置写 0，无需擦除)
+#define PRODUCT_MAGIC_VERSION   0x5645524E  // 增量日志中的版本记录 ('VERN')，id 字段存放新版本号，price 字段存放内容校验和
 
 // Flash 地址规划 (基于 W25Q64)
 // 扇区 0 (0x000000 - 0x000FFF): 存放系统元数据 (商品总数、版本等)
 #define FLASH_ADDR_METADATA     0x000000  
+// 扇区 0 后半部分 (0x000100 - 0x000FFF): 同步进度检查点 (追加写入，同步开始时随扇区 0 一起擦除)
+#define FLASH_ADDR_SYNC_PROGRESS 0x000100
 // 扇区 1 (0x001000) 开始: 存放具体商品数据
 #define FLASH_ADDR_DB_START     0x001000  
+// 0x05F000: 元数据备份扇区，与扇区 0 交替写入 (各带序号，取较新的一份)，整理时掉电至少保留一份完整的元数据
+#define FLASH_ADDR_METADATA_B   0x05F000
+// 0x060000 开始: 增量更新日志 (追加写入，整理后擦除)，位于商品区最大范围 (5000 * 64) 之后
+#define FLASH_ADDR_DELTA_LOG    0x060000
+#define DELTA_LOG_SECTORS       4                                   // 4 个扇区 = 16KB
+#define DELTA_LOG_MAX_ENTRIES   (DELTA_LOG_SECTORS * 4096 / 64)     // 最多 256 条记录
+#define DELTA_COMPACT_THRESHOLD (DELTA_LOG_MAX_ENTRIES / 2)         // 空闲时超过该条数即整理
+// 0x064000 开始: 备用主表区。整理时主表已满 (删除标记占位)，把有效商品重写到另一个区，
+// 元数据中的 db_base 切换后旧区作废；两个区都能容纳 PRODUCT_MAX_COUNT 条
+#define FLASH_ADDR_DB_ALT       0x064000
+#define PRODUCT_ITEMS_PER_SECTOR (4096 / 64)
 
 // 最大支持商品数量 (防止遍历死循环)
 #define PRODUCT_MAX_COUNT       5000  
 
+// 同步进度检查点
+#define PRODUCT_MAGIC_SYNC         0x5A5A5A5A  // 检查点有效标记
+#define SYNC_CHECKPOINT_INTERVAL   32          // 每写入 32 条商品 (8 页 Flash) 保存一次进度
+#define PRODUCT_CHECKSUM_INIT      0x811C9DC5  // 运行校验和初值 (FNV-1a 32 位)
+
+// 价格统一以"分"为单位的整数保存与累加 (Cortex-M3 无 FPU，避免软件浮点)
+// 输出时拆成元和分：printf(PRICE_FMT, PRICE_ARGS(cents)) -> "12.50"
+#define PRICE_FMT               "%lu.%02lu"
+#define PRICE_ARGS(cents)       (unsigned long)((cents) / 100), (unsigned long)((cents) % 100)
+
 // ==========================================
 // 2. 数据结构定义
 // ==========================================
@@ -29,20 +56,36 @@
 // 元数据结构 (存放在 Sector 0)
 typedef struct {
     uint32_t total_count;       // 当前存储的商品总数
-    uint32_t update_timestamp;  // 更新时间戳 (可选)
-    uint32_t version;           // 数据库版本
+    uint32_t update_timestamp;  // 更新时间戳 (上位机在 SYNC_END 中通过 TS 下发)
+    uint32_t version;           // 商品库版本 (上位机通过 VER 下发)
     uint32_t magic;             // 元数据有效标记
+    uint32_t content_hash;      // 内容校验和：有效商品 Product_Item_Hash 之和，与顺序无关 (放在 magic 之后，兼容旧元数据布局)
+    // 以下字段在旧元数据中为 0xFFFFFFFF (未写入)，读出时按缺省值处理
+    uint32_t seq;               // 写入序号，扇区 0 与备份扇区中取较大的一份
+    uint32_t db_base;           // 当前主表起始地址 (FLASH_ADDR_DB_START / FLASH_ADDR_DB_ALT)
+    uint32_t db_extent;         // 当前主表区写过的最大记录数，全量同步时擦除到这里
 } Product_Metadata_t;
 
 // 商品存储结构 (定长 64 字节)
 // 必须定长，以便通过 index 直接计算地址
 typedef struct {
     uint64_t id;          // 条码 (Key) - 支持 13 位条码
-    float    price;       // 价格
+    uint32_t price;       // 价格 (分)；V1 记录中为 float，读出时已换算
     char     name[48];    // 名称 (UTF-8)
-    uint32_t magic;       // 有效标记
+    uint32_t magic;       // 有效标记 (PRODUCT_MAGIC_VALID / _V1 / _DELETED)
 } Product_Item_t;
 
+// 同步进度检查点 (存放在 Sector 0 的 FLASH_ADDR_SYNC_PROGRESS 之后，每条 16 字节)
+// Flash 只能把 1 写成 0，所以检查点采用追加写入，最后一条有效记录即为当前进度
+typedef struct {
+    uint32_t expect_total;      // 上位机告知的预期总数
+    uint32_t received_cnt;      // 已连续写入 Flash 的商品数量
+    uint32_t checksum;          // 前 received_cnt 条商品的运行校验和
+    uint32_t magic;             // 检查点有效标记 (PRODUCT_MAGIC_SYNC)
+} Product_Sync_Progress_t;
+
+#define SYNC_PROGRESS_SLOT_COUNT  ((FLASH_ADDR_DB_START - FLASH_ADDR_SYNC_PROGRESS) / sizeof(Product_Sync_Progress_t))
+
 typedef char Product_Item_t_size_must_be_64_bytes[(sizeof(Product_Item_t) == 64) ? 1 : -1];
 
 // 获取单个商品占用的 Flash 字节数
@@ -56,29 +99,52 @@ typedef char Product_Item_t_size_must_be_64_bytes[(sizeof(Product_Item_t) == 64)
 void Product_Manager_Init(void);
 
 /* 数据库管理 */
-void Product_Clear_Database(void);           // 擦除数据库
-void Product_Update_Metadata(uint32_t count);// 更新商品总数
+// 擦除数据库 (全量同步开始时)，擦除范围覆盖 expect_total 条和主表区用过的全部扇区
+void Product_Clear_Database(uint32_t expect_total);
+// 同步结束时更新元数据 (总数、版本、时间戳)，内容校验和由主表重新计算
+void Product_Update_Metadata(uint32_t count, uint32_t version, uint32_t timestamp);
+// 获取当前元数据 (RAM 缓存，版本号已包含增量日志中的更新)
+void Product_Get_Metadata(Product_Metadata_t *out_meta);
+
+/* 同步断点续传 */
+// 运行校验和：按 ID(8字节小端) + 价格(分，uint32 4字节小端) + 名称(不含结尾 0) 的顺序做 FNV-1a
+uint32_t Product_Checksum_Update(uint32_t sum, uint64_t id, uint32_t price, const char *name);
+// 单个商品的哈希 = Product_Checksum_Update(PRODUCT_CHECKSUM_INIT, ...)；DB_INFO 的 HASH 为全部有效商品之和 (mod 2^32)
+uint32_t Product_Item_Hash(uint64_t id, uint32_t price, const char *name);
+// 追加保存一条同步进度检查点
+void Product_Save_Sync_Progress(uint32_t expect_total, uint32_t received_cnt, uint32_t checksum);
+// 读取最近一次被中断的同步进度，1=存在可续传的进度, 0=无
+uint8_t Product_Load_Sync_Progress(Product_Sync_Progress_t *out_progress);
 
 /* 写操作 */
 // 将商品写入指定索引位置
-void Product_Write_Item(uint32_t index, uint64_t id, float price, char* name);
+void Product_Write_Item(uint32_t index, uint64_t id, uint32_t price, char* name);
+
+/* 增量更新 (写入增量日志，不擦除主表) */
+// 新增或修改单个商品 (日志满时会先自动整理)，1=成功, 0=日志已满且商品库已满无法整理
+uint8_t Product_Upsert(uint64_t id, uint32_t price, char *name);
+// 删除单个商品，1=成功, 0=商品不存在或日志已满
+uint8_t Product_Delete(uint64_t id);
+// 增量更新后设置商品库版本 (写入日志，连同当前内容校验和一起持久化)，每次增删改后调用
+void Product_Set_Version(uint32_t version);
+// 增量日志中的记录数
+uint32_t Product_Delta_Count(void);
+// 把增量日志合并回主表并清空日志，1=完成, 0=商品库放不下 (日志保持不变)
+uint8_t Product_Delta_Compact(void);
 
 /* 读/查操作 */
 // 根据索引读取 (用于遍历)
 uint8_t Product_Read_ByIndex(uint32_t index, Product_Item_t *out_item);
-// 根据 ID 查找 (用于扫码) - 核心功能
+// 根据 ID 查找 (用于扫码) - 核心功能，先查增量日志再查主表
 uint8_t Product_Find_By_ID(uint64_t target_id, Product_Item_t *out_item);
+// 批量查找 (用于整篮扫码)：sorted_ids 须升序且无重复，只遍历一次日志和主表
+// found[k]=1 表示 out_items[k] 有效，返回找到的数量
+uint8_t Product_Find_Batch(const uint64_t *sorted_ids, uint8_t count, Product_Item_t *out_items, uint8_t *found);
 
 void Product_Get_All_Info(Product_Item_t* list, int totalItems);
 
 /* 调试 */
 void Product_Debug_Dump_All(void);
 
-//---------用于MCU内部产品列表刷新---------
-#define DATA_BUFFER_VOLUME 66 // MCU端商品数据缓冲区大小
-typedef struct{
-    Product_Item_t product;
-    int num;
-} MCU_Product_t; // MCU端商品结构体
 
 #endif /* __PRODUCT_H */
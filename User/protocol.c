@@ -1,41 +1,63 @@
 #include "protocol.h"
+#include "bsp_usart_dma.h"
+#include "log.h"
+#include <stdarg.h>
 
 ProtocolManager_t g_protocol;
 
+// 应答帧拼装缓冲区 (只在主循环中使用)
+static char g_reply_buf[PROTOCOL_REPLY_SIZE];
+
 void Protocol_Init(void) {
     memset(&g_protocol, 0, sizeof(g_protocol));
+    SPSC_Init(&g_protocol.rx, g_protocol.rx_buf, RING_BUFFER_SIZE);
 }
 
 // --- [关键] 中断调用的入队函数 ---
 void Protocol_Receive_Byte_IRQ(uint8_t byte) {
-    uint16_t next_head = (g_protocol.head + 1) % RING_BUFFER_SIZE;
-    // 如果缓冲区未满，则存入
-    if (next_head != g_protocol.tail) {
-        g_protocol.ring_buf[g_protocol.head] = byte;
-        g_protocol.head = next_head;
-    }
+    // 缓冲区满时丢弃
+    SPSC_Put(&g_protocol.rx, byte);
+}
+
+// --- 中断中读 DR 之前调用，记录 ORE/FE/NE ---
+void Protocol_Receive_Error_IRQ(uint16_t sr) {
+    USART_Rx_Count_Errors(sr, &g_protocol.rx_err);
+}
+
+// --- 接收链路统计 (CMD:LINK_STATS) ---
+void Protocol_Get_Link_Stats(USART_Rx_Stats_t *out) {
+    out->dropped = g_protocol.rx.dropped;
+    out->high_water = g_protocol.rx.high_water;
+    out->size = SPSC_Size(&g_protocol.rx);
+    out->overrun = g_protocol.rx_err.overrun;
+    out->framing = g_protocol.rx_err.framing;
+    out->noise = g_protocol.rx_err.noise;
+    out->truncated = g_protocol.line_truncated;
 }
 
 // --- 内部工具：提取 Key:Value ---
+// 只认 ",Key:" 开头的字段，NM:SILVER 里的 VER、NM:PEANUTS 里的 TS 不算
 static void Get_Value_By_Key(const char *line, const char *key, char *out_val, uint16_t max_len) {
-    char *p = strstr(line, key);
+    size_t key_len = strlen(key);
+    const char *p = strstr(line, key);
+
+    while (p && (p == line || p[-1] != ',' || p[key_len] != ':')) {
+        p = strstr(p + 1, key);
+    }
     if (p) {
-        p += strlen(key); // 跳过Key
-        if (*p == ':') {
-            p++; // 跳过冒号
-            uint16_t i = 0;
-            // 读取直到遇到逗号或换行
-            while (*p != ',' && *p != '\0' && *p != '\r' && *p != '\n' && i < max_len - 1) {
-                out_val[i++] = *p++;
-            }
-            out_val[i] = '\0';
+        p += key_len + 1; // 跳过Key和冒号
+        uint16_t i = 0;
+        // 读取直到遇到逗号或换行
+        while (*p != ',' && *p != '\0' && *p != '\r' && *p != '\n' && i < max_len - 1) {
+            out_val[i++] = *p++;
         }
+        out_val[i] = '\0';
     } else {
         out_val[0] = '\0';
     }
 }
 
-static uint8_t Parse_U64_Dec(const char *s, uint64_t *out_val)
+uint8_t Parse_U64_Dec(const char *s, uint64_t *out_val)
 {
     if (s == NULL || *s == '\0')
     {
@@ -53,59 +75,295 @@ static uint8_t Parse_U64_Dec(const char *s, uint64_t *out_val)
     return 1;
 }
 
-// --- 主循环调用的解析函数 ---
-uint8_t Protocol_Parse_Line(ParsedPacket_t *out_packet) {
-    // 从 RingBuffer 取数据，尝试拼凑一行
-    while (g_protocol.tail != g_protocol.head) {
-        char ch = g_protocol.ring_buf[g_protocol.tail];
-        g_protocol.tail = (g_protocol.tail + 1) % RING_BUFFER_SIZE;
+// --- 内部工具：解析价格 "5.99" -> 599 (分)，纯整数运算，第三位小数四舍五入 ---
+static uint32_t Parse_Price_Cents(const char *s)
+{
+    uint32_t yuan = 0;
+    uint32_t cents = 0;
+    uint8_t digits = 0;
 
-        if (ch == '\n') { // 换行符，一行结束，开始解析
-            g_protocol.line_buf[g_protocol.line_idx] = '\0';
-            g_protocol.line_idx = 0;
+    while (*s >= '0' && *s <= '9') {
+        yuan = yuan * 10 + (*s++ - '0');
+    }
+    if (*s == '.') {
+        s++;
+        while (*s >= '0' && *s <= '9' && digits < 2) {
+            cents = cents * 10 + (*s++ - '0');
+            digits++;
+        }
+        if (digits == 1) {
+            cents *= 10;
+        }
+        if (digits == 2 && *s >= '5' && *s <= '9') {
+            cents++;
+        }
+    }
+    return yuan * 100 + cents;
+}
 
-            char temp_val[64];
-            
-            // 1. 识别 START
-            if (strstr(g_protocol.line_buf, "CMD:SYNC_START")) {
-                out_packet->event = EVENT_SYNC_START;
-                Get_Value_By_Key(g_protocol.line_buf, "TOTAL", temp_val, 32);
-                out_packet->total_count = atoi(temp_val);
-                return 1;
+// --- 内部工具：解析可选的 VER / TS 字段 ---
+static void Parse_Version_Fields(const char *line, ParsedPacket_t *out_packet)
+{
+    char temp_val[16];
+
+    Get_Value_By_Key(line, "VER", temp_val, sizeof(temp_val));
+    out_packet->version_valid = (temp_val[0] != '\0');
+    out_packet->version = strtoul(temp_val, NULL, 10);
+
+    Get_Value_By_Key(line, "TS", temp_val, sizeof(temp_val));
+    out_packet->timestamp = strtoul(temp_val, NULL, 10);
+}
+
+// --- 内部工具：解析 IDS:a;b;c 条码列表 (直接在行缓冲区上解析，不经过 temp_val) ---
+static void Parse_Batch_IDs(const char *line, ParsedPacket_t *out_packet)
+{
+    const char *p = strstr(line, "IDS:");
+
+    out_packet->batch_count = 0;
+    out_packet->batch_invalid = 0;
+    if (p == NULL) {
+        return;
+    }
+    p += 4;
+
+    while (*p != '\0' && *p != ',') {
+        char *endptr = NULL;
+        unsigned long long v = strtoull(p, &endptr, 10);
+
+        if (endptr == p || (*endptr != ';' && *endptr != ',' && *endptr != '\0')
+            || endptr - p > 20 || Barcode_Validate(p, (uint8_t)(endptr - p)) >= BARCODE_BAD_FORMAT) {
+            // 非法条码 (含校验位错误)：跳到下一个分隔符
+            out_packet->batch_invalid++;
+            while (*p != ';' && *p != ',' && *p != '\0') {
+                p++;
             }
-            // 2. 识别 DATA
-            else if (strstr(g_protocol.line_buf, "CMD:SYNC_DATA")) {
-                out_packet->event = EVENT_SYNC_DATA;
-                
-                Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
-                out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
-                
-                Get_Value_By_Key(g_protocol.line_buf, "PR", temp_val, 32);
-                out_packet->price = atof(temp_val);
-                
-                Get_Value_By_Key(g_protocol.line_buf, "NM", out_packet->name, sizeof(out_packet->name));
-                return 1;
+        } else {
+            if (out_packet->batch_count < SCAN_BATCH_MAX) {
+                out_packet->batch_ids[out_packet->batch_count++] = (uint64_t)v;
+            } else {
+                out_packet->batch_invalid++;
             }
-            // 3. 识别 END
-            else if (strstr(g_protocol.line_buf, "CMD:SYNC_END")) {
-                out_packet->event = EVENT_SYNC_END;
-                Get_Value_By_Key(g_protocol.line_buf, "SUM", temp_val, 32);
-                out_packet->total_count = atoi(temp_val);
+            p = endptr;
+        }
+        if (*p == ';') {
+            p++;
+        }
+    }
+}
+
+// --- 内部工具：解析可选的 SEQ 字段 ---
+static void Parse_Seq_Field(const char *line, ParsedPacket_t *out_packet)
+{
+    char temp_val[16];
+
+    Get_Value_By_Key(line, "SEQ", temp_val, sizeof(temp_val));
+    out_packet->seq_valid = (temp_val[0] != '\0');
+    out_packet->seq = strtoul(temp_val, NULL, 10);
+}
+
+// --- 从接收缓冲区拼出一行：原地扫描连续区域，按段批量消费 ---
+static uint8_t Protocol_Fetch_Line(void) {
+    const uint8_t *data;
+    uint16_t n, i;
+
+    while ((n = SPSC_Peek_Contig(&g_protocol.rx, &data)) > 0) {
+        for (i = 0; i < n; i++) {
+            char ch = (char)data[i];
+
+            if (ch == '\n') { // 换行符，一行结束
+                SPSC_Consume(&g_protocol.rx, i + 1);
+                g_protocol.line_buf[g_protocol.line_idx] = '\0';
+                g_protocol.line_idx = 0;
+                if (g_protocol.line_overflow) {
+                    g_protocol.line_overflow = 0;
+                    g_protocol.line_truncated++;
+                    LOG_W("[Proto] Line truncated to %d bytes: %.32s...\r\n",
+                          LINE_BUFFER_SIZE - 1, g_protocol.line_buf);
+                }
                 return 1;
             }
-             // 4. 识别 SCAN
-            else if (strstr(g_protocol.line_buf, "CMD:SCAN")) {
-                out_packet->event = EVENT_SCAN;
-                Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
-                out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
-                return 1;
+            if (ch != '\r') {
+                if (g_protocol.line_idx < LINE_BUFFER_SIZE - 1) {
+                    g_protocol.line_buf[g_protocol.line_idx++] = ch;
+                } else {
+                    g_protocol.line_overflow = 1;
+                }
             }
-        } 
-        else if (ch != '\r') {
-            if (g_protocol.line_idx < LINE_BUFFER_SIZE - 1) {
-                g_protocol.line_buf[g_protocol.line_idx++] = ch;
+        }
+        SPSC_Consume(&g_protocol.rx, n);
+    }
+    return 0;
+}
+
+// --- 主循环调用的解析函数 ---
+uint8_t Protocol_Parse_Line(ParsedPacket_t *out_packet) {
+    // 从 RingBuffer 取数据，尝试拼凑一行；不认识的指令直接跳过，继续取下一行
+    while (Protocol_Fetch_Line()) {
+        char temp_val[64];
+        
+        // 1. 识别 START
+        if (strstr(g_protocol.line_buf, "CMD:SYNC_START")) {
+            out_packet->event = EVENT_SYNC_START;
+            Get_Value_By_Key(g_protocol.line_buf, "TOTAL", temp_val, 32);
+            out_packet->total_count = atoi(temp_val);
+            return 1;
+        }
+        // 2. 识别 DATA
+        else if (strstr(g_protocol.line_buf, "CMD:SYNC_DATA")) {
+            out_packet->event = EVENT_SYNC_DATA;
+            
+            Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
+            out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
+            
+            Get_Value_By_Key(g_protocol.line_buf, "PR", temp_val, 32);
+            out_packet->price = Parse_Price_Cents(temp_val);
+            
+            Get_Value_By_Key(g_protocol.line_buf, "NM", out_packet->name, sizeof(out_packet->name));
+            return 1;
+        }
+        // 3. 识别 END
+        else if (strstr(g_protocol.line_buf, "CMD:SYNC_END")) {
+            out_packet->event = EVENT_SYNC_END;
+            Get_Value_By_Key(g_protocol.line_buf, "SUM", temp_val, 32);
+            out_packet->total_count = atoi(temp_val);
+            Parse_Version_Fields(g_protocol.line_buf, out_packet);
+            return 1;
+        }
+         // 4. 识别 SCAN_BATCH (必须在 SCAN 之前判断，否则会被 "CMD:SCAN" 匹配)
+        else if (strstr(g_protocol.line_buf, "CMD:SCAN_BATCH")) {
+            out_packet->event = EVENT_SCAN_BATCH;
+            Parse_Batch_IDs(g_protocol.line_buf, out_packet);
+            Parse_Seq_Field(g_protocol.line_buf, out_packet);
+            return 1;
+        }
+         // 4. 识别 SCAN
+        else if (strstr(g_protocol.line_buf, "CMD:SCAN")) {
+            out_packet->event = EVENT_SCAN;
+            Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
+            out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
+            // 校验位/长度/前缀不对的误读条码在这里拦下，不再去 Flash 里查
+            out_packet->id_check = Barcode_Validate(temp_val, (uint8_t)strlen(temp_val));
+
+            // 可选 SEQ：PC 可连续发送多条扫码，用序号匹配回复
+            Parse_Seq_Field(g_protocol.line_buf, out_packet);
+            return 1;
+        }
+        // 5. 识别 SYNC_RESUME (断点续传查询)
+        else if (strstr(g_protocol.line_buf, "CMD:SYNC_RESUME")) {
+            out_packet->event = EVENT_SYNC_RESUME;
+            return 1;
+        }
+        // 6. 识别 UPSERT (增量新增/修改)
+        else if (strstr(g_protocol.line_buf, "CMD:UPSERT")) {
+            out_packet->event = EVENT_UPSERT;
+
+            Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
+            out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
+
+            Get_Value_By_Key(g_protocol.line_buf, "PR", temp_val, 32);
+            out_packet->price = Parse_Price_Cents(temp_val);
+
+            Get_Value_By_Key(g_protocol.line_buf, "NM", out_packet->name, sizeof(out_packet->name));
+            Parse_Version_Fields(g_protocol.line_buf, out_packet);
+            return 1;
+        }
+        // 7. 识别 DELETE (增量删除)
+        else if (strstr(g_protocol.line_buf, "CMD:DELETE")) {
+            out_packet->event = EVENT_DELETE;
+            Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
+            out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
+            Parse_Version_Fields(g_protocol.line_buf, out_packet);
+            return 1;
+        }
+        // 8. 识别 HELLO / DB_INFO (商品库版本握手)
+        else if (strstr(g_protocol.line_buf, "CMD:HELLO") || strstr(g_protocol.line_buf, "CMD:DB_INFO")) {
+            out_packet->event = EVENT_HELLO;
+            return 1;
+        }
+        // 9. 识别 SET_BAUD (波特率协商)
+        else if (strstr(g_protocol.line_buf, "CMD:SET_BAUD")) {
+            out_packet->event = EVENT_SET_BAUD;
+            Get_Value_By_Key(g_protocol.line_buf, "BAUD", temp_val, 32);
+            out_packet->baudrate = strtoul(temp_val, NULL, 10);
+            return 1;
+        }
+        // 10. 识别 PING (新波特率验证 / 链路探测)
+        else if (strstr(g_protocol.line_buf, "CMD:PING")) {
+            out_packet->event = EVENT_PING;
+            return 1;
+        }
+        // 11. 识别 LOG (运行时调整调试日志等级/限速)
+        else if (strstr(g_protocol.line_buf, "CMD:LOG")) {
+            out_packet->event = EVENT_LOG_CFG;
+            Get_Value_By_Key(g_protocol.line_buf, "LEVEL", temp_val, 32);
+            out_packet->log_level_valid = (temp_val[0] != '\0');
+            out_packet->log_level = (uint8_t)strtoul(temp_val, NULL, 10);
+            Get_Value_By_Key(g_protocol.line_buf, "RATE", temp_val, 32);
+            out_packet->log_rate_valid = (temp_val[0] != '\0');
+            out_packet->log_rate = strtoul(temp_val, NULL, 10);
+            return 1;
+        }
+        // 12. 识别 LINK_STATS (串口链路统计查询)
+        else if (strstr(g_protocol.line_buf, "CMD:LINK_STATS")) {
+            out_packet->event = EVENT_LINK_STATS;
+            return 1;
+        }
+        // 13. 识别 CART_VOID (按行号删除购物车中的一行；"VOID" 中含 "ID"，不解析 ID 字段)
+        else if (strstr(g_protocol.line_buf, "CMD:CART_VOID")) {
+            out_packet->event = EVENT_CART_VOID;
+            Get_Value_By_Key(g_protocol.line_buf, "LINE", temp_val, 32);
+            out_packet->line_no = strtoul(temp_val, NULL, 10);
+            Parse_Seq_Field(g_protocol.line_buf, out_packet);
+            return 1;
+        }
+        // 14. 识别 CART_REMOVE / CART_DEC / CART_SET (按条码修改购物车)
+        else if (strstr(g_protocol.line_buf, "CMD:CART_")) {
+            if (strstr(g_protocol.line_buf, "CMD:CART_REMOVE")) {
+                out_packet->event = EVENT_CART_REMOVE;
+            } else if (strstr(g_protocol.line_buf, "CMD:CART_DEC")) {
+                out_packet->event = EVENT_CART_DEC;
+            } else if (strstr(g_protocol.line_buf, "CMD:CART_SET")) {
+                out_packet->event = EVENT_CART_SET;
+            } else {
+                continue;
             }
+            Get_Value_By_Key(g_protocol.line_buf, "ID", temp_val, 32);
+            out_packet->id_valid = Parse_U64_Dec(temp_val, &out_packet->id);
+
+            Get_Value_By_Key(g_protocol.line_buf, "QTY", temp_val, 32);
+            out_packet->qty_valid = (temp_val[0] != '\0');
+            out_packet->qty = strtoul(temp_val, NULL, 10);
+
+            Parse_Seq_Field(g_protocol.line_buf, out_packet);
+            return 1;
         }
     }
     return 0; // 没拼凑出一整行
 }
+
+// --- 应答发送：整帧写入 USART1 的协议通道，优先于调试日志发送 ---
+static void Protocol_Reply_Flush(uint16_t len) {
+    if (len == 0 || g_reply_buf[len - 1] != '\n') {
+        g_reply_buf[len++] = '\n';
+    }
+    USART_TX_Write(USART_TX_CH_PROTO, (const uint8_t *)g_reply_buf, len);
+}
+
+char *Protocol_Reply_Buffer(void) {
+    return g_reply_buf;
+}
+
+void Protocol_Reply_Send(const char *end) {
+    Protocol_Reply_Flush((uint16_t)(end - g_reply_buf));
+}
+
+// 单行应答，用法同 printf，例如 Protocol_Reply("CMD:PONG,BAUD:%lu\n", baud)
+void Protocol_Reply(const char *fmt, ...) {
+    va_list args;
+    int n;
+
+    va_start(args, fmt);
+    n = vsnprintf(g_reply_buf, PROTOCOL_REPLY_SIZE - 1, fmt, args);
+    va_end(args);
+    Protocol_Reply_Flush((n < 0) ? 0 : ((n > PROTOCOL_REPLY_SIZE - 2) ? PROTOCOL_REPLY_SIZE - 2 : n));
+}
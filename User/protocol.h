@@ -6,6 +6,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include "spsc_ring.h"
+#include "bsp_usart_dma.h"
+#include "barcode.h"
 
 // ==========================================
 // 1. Flash 存储结构定义 (定长 64字节)
@@ -13,7 +16,7 @@
 // 256字节(一页) / 64 = 4，完美对齐，无跨页写入风险
 typedef struct {
     uint64_t id;          // 商品条码 (支持 EAN-13 等 13 位条码)
-    float    price;       // 价格
+    uint32_t price;       // 价格 (分)
     char     name[48];    // 商品名称 (UTF-8)
     uint32_t magic;       // 有效标志位 (0xA5A5A5A5)
 } Product_Flash_Store_t;
@@ -28,8 +31,10 @@ typedef char Product_Flash_Store_t_size_must_be_64_bytes[(sizeof(Product_Flash_S
 // ==========================================
 // 2. 串口协议定义
 // ==========================================
-#define RING_BUFFER_SIZE  1024  // 加大缓冲区，防止擦除Flash时溢出
-#define LINE_BUFFER_SIZE  128
+#define RING_BUFFER_SIZE  1024  // 加大缓冲区，防止擦除Flash时溢出 (必须是 2 的幂)
+#define LINE_BUFFER_SIZE  256   // 需容纳 SCAN_BATCH 的一整行条码
+#define SCAN_BATCH_MAX    16    // CMD:SCAN_BATCH 单帧最多条码数
+#define PROTOCOL_REPLY_SIZE 768 // 单条应答最大长度 (SCAN_BATCH 汇总回复最长：16 条 20 位条码约 680 字节)
 
 // 解析出的事件类型
 typedef enum {
@@ -37,7 +42,20 @@ typedef enum {
     EVENT_SYNC_START,       // CMD:SYNC_START
     EVENT_SYNC_DATA,        // CMD:SYNC_DATA
     EVENT_SYNC_END,         // CMD:SYNC_END
-    EVENT_SCAN              // CMD:SCAN
+    EVENT_SCAN,             // CMD:SCAN
+    EVENT_SYNC_RESUME,      // CMD:SYNC_RESUME
+    EVENT_UPSERT,           // CMD:UPSERT
+    EVENT_DELETE,           // CMD:DELETE
+    EVENT_HELLO,            // CMD:HELLO / CMD:DB_INFO
+    EVENT_SET_BAUD,         // CMD:SET_BAUD
+    EVENT_PING,             // CMD:PING
+    EVENT_SCAN_BATCH,       // CMD:SCAN_BATCH
+    EVENT_LOG_CFG,          // CMD:LOG
+    EVENT_LINK_STATS,       // CMD:LINK_STATS
+    EVENT_CART_REMOVE,      // CMD:CART_REMOVE
+    EVENT_CART_DEC,         // CMD:CART_DEC
+    EVENT_CART_SET,         // CMD:CART_SET
+    EVENT_CART_VOID         // CMD:CART_VOID
 } ProtocolEvent_t;
 
 // 解析结果包
@@ -46,23 +64,52 @@ typedef struct {
     uint32_t total_count;   // 对应 TOTAL/SUM
     uint64_t id;            // 对应 ID
     uint8_t id_valid;       // 1=ID解析成功(纯数字且未溢出), 0=无效
-    float price;            // 对应 PR
+    uint8_t id_check;       // Barcode_Result_t，条码校验结果 (仅 CMD:SCAN)
+    uint32_t price;         // 对应 PR (解析为分，"5.99" -> 599)
     char name[48];          // 对应 NM
+    uint32_t version;       // 对应 VER (商品库版本，可选)
+    uint8_t version_valid;  // 1=携带了 VER 字段
+    uint32_t timestamp;     // 对应 TS (更新时间戳，可选，缺省为 0)
+    uint32_t baudrate;      // 对应 BAUD
+    uint32_t seq;           // 对应 SEQ (请求序号，回复中回显，可选)
+    uint8_t seq_valid;      // 1=携带了 SEQ 字段
+    uint64_t batch_ids[SCAN_BATCH_MAX]; // 对应 IDS (分号分隔的条码列表)
+    uint8_t batch_count;    // 成功解析的条码数
+    uint8_t batch_invalid;  // 无法解析、条码校验失败或超出 SCAN_BATCH_MAX 的条码数
+    uint8_t log_level;      // 对应 LEVEL (CMD:LOG)
+    uint8_t log_level_valid;
+    uint32_t log_rate;      // 对应 RATE (CMD:LOG，日志限速 字节/秒，0=不限)
+    uint8_t log_rate_valid;
+    uint32_t qty;           // 对应 QTY (CMD:CART_DEC / CMD:CART_SET 的数量)
+    uint8_t qty_valid;      // 1=携带了 QTY 字段
+    uint32_t line_no;       // 对应 LINE (CMD:CART_VOID，购物车行号，从 1 开始)
 } ParsedPacket_t;
 
 // 协议管理器句柄
 typedef struct {
-    uint8_t ring_buf[RING_BUFFER_SIZE];
-    volatile uint16_t head;
-    volatile uint16_t tail;
+    uint8_t rx_buf[RING_BUFFER_SIZE];
+    SPSC_Ring_t rx;         // 接收中断写入，主循环读取
     
     char line_buf[LINE_BUFFER_SIZE];
     uint16_t line_idx;
+    uint8_t line_overflow;  // 当前行已超过 LINE_BUFFER_SIZE
+    uint32_t line_truncated;
+    USART_Rx_Errors_t rx_err;
 } ProtocolManager_t;
 
 // API
 void Protocol_Init(void);
 void Protocol_Receive_Byte_IRQ(uint8_t byte);
+void Protocol_Receive_Error_IRQ(uint16_t sr);
+void Protocol_Get_Link_Stats(USART_Rx_Stats_t *out);
+// 十进制条码字符串 -> uint64 (纯数字且未溢出返回 1)，扫码枪直连口复用
+uint8_t Parse_U64_Dec(const char *s, uint64_t *out_val);
 uint8_t Protocol_Parse_Line(ParsedPacket_t *out_packet);
+// 应答走协议通道 (整帧入队、优先发送)，调试日志仍用 printf / LOG_x
+void Protocol_Reply(const char *fmt, ...);
+// 热路径：用 fmt.h 直接在应答缓冲区中拼装，p = Protocol_Reply_Buffer(); ... Protocol_Reply_Send(p);
+// 可用空间 PROTOCOL_REPLY_SIZE - 1 (留一个字节给结尾换行)
+char *Protocol_Reply_Buffer(void);
+void Protocol_Reply_Send(const char *end);
 
 #endif
@@ -0,0 +1,201 @@
+#include "scanner.h"
+#include "log.h"
+#include <string.h>
+
+// DMA 循环写入 g_scanner_dma_buf；中断里按 DMA 写位置推进 g_scanner_rx.head，主循环按 SPSC 方式读取
+static uint8_t g_scanner_dma_buf[SCANNER_DMA_BUF_SIZE];
+static SPSC_Ring_t g_scanner_rx;
+static uint16_t g_scanner_dma_pos;      // 上次同步时的 DMA 写位置
+static USART_Rx_Errors_t g_scanner_err;
+
+// 主循环拼条码
+static char g_scanner_code[SCANNER_CODE_MAX];
+static uint8_t g_scanner_code_len;
+static uint8_t g_scanner_code_overflow; // 当前条码超长，等结束符后整条丢弃
+static uint32_t g_scanner_truncated;
+
+void Scanner_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStructure;
+    USART_InitTypeDef USART_InitStructure;
+    DMA_InitTypeDef DMA_InitStructure;
+    NVIC_InitTypeDef NVIC_InitStruct;
+
+    SPSC_Init(&g_scanner_rx, g_scanner_dma_buf, SCANNER_DMA_BUF_SIZE);
+    g_scanner_dma_pos = 0;
+
+    SCANNER_GPIO_APBxClkCmd(SCANNER_GPIO_CLK, ENABLE);
+    SCANNER_USART_APBxClkCmd(SCANNER_USART_CLK, ENABLE);
+    RCC_AHBPeriphClockCmd(SCANNER_DMA_CLK, ENABLE);
+
+    // RX 上拉输入：未接扫码枪时保持空闲高电平，避免悬空产生帧错误和乱码
+    GPIO_InitStructure.GPIO_Pin = SCANNER_RX_GPIO_PIN;
+    GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
+    GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(SCANNER_RX_GPIO_PORT, &GPIO_InitStructure);
+
+    USART_InitStructure.USART_BaudRate = SCANNER_USART_BAUDRATE;
+    USART_InitStructure.USART_WordLength = USART_WordLength_8b;
+    USART_InitStructure.USART_StopBits = USART_StopBits_1;
+    USART_InitStructure.USART_Parity = USART_Parity_No;
+    USART_InitStructure.USART_HardwareFlowControl = USART_HardwareFlowControl_None;
+    USART_InitStructure.USART_Mode = USART_Mode_Rx;
+    USART_Init(SCANNER_USARTx, &USART_InitStructure);
+
+    // 外设 -> 内存，循环模式，DMA 不停止，主循环只需跟上写位置
+    DMA_DeInit(SCANNER_DMA_CHANNEL);
+    DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&SCANNER_USARTx->DR;
+    DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)g_scanner_dma_buf;
+    DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_InitStructure.DMA_BufferSize = SCANNER_DMA_BUF_SIZE;
+    DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+    DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+    DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+    DMA_Init(SCANNER_DMA_CHANNEL, &DMA_InitStructure);
+    // 半满/全满中断保证连续数据不空闲时也能及时推进写位置
+    DMA_ITConfig(SCANNER_DMA_CHANNEL, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    // 两个中断同一抢占优先级，互不打断，写位置只在其中一个里更新
+    NVIC_InitStruct.NVIC_IRQChannel = SCANNER_USART_IRQ;
+    NVIC_InitStruct.NVIC_IRQChannelPreemptionPriority = 1;
+    NVIC_InitStruct.NVIC_IRQChannelSubPriority = 2;
+    NVIC_InitStruct.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_InitStruct);
+    NVIC_InitStruct.NVIC_IRQChannel = SCANNER_DMA_IRQ;
+    NVIC_Init(&NVIC_InitStruct);
+
+    USART_DMACmd(SCANNER_USARTx, USART_DMAReq_Rx, ENABLE);
+    USART_ITConfig(SCANNER_USARTx, USART_IT_IDLE, ENABLE);
+    DMA_Cmd(SCANNER_DMA_CHANNEL, ENABLE);
+    USART_Cmd(SCANNER_USARTx, ENABLE);
+}
+
+// 中断中调用：按 DMA 剩余计数推进 head；主循环落后超过一整圈时记为丢弃
+static void Scanner_Sync_DMA_Pos(void)
+{
+    uint16_t pos = (SCANNER_DMA_BUF_SIZE - DMA_GetCurrDataCounter(SCANNER_DMA_CHANNEL)) & (SCANNER_DMA_BUF_SIZE - 1);
+    uint16_t n = (pos - g_scanner_dma_pos) & (SCANNER_DMA_BUF_SIZE - 1);
+    uint16_t used;
+
+    if (n == 0)
+    {
+        return;
+    }
+    g_scanner_dma_pos = pos;
+
+    used = (uint16_t)(g_scanner_rx.head - g_scanner_rx.tail) + n;
+    if (used > SCANNER_DMA_BUF_SIZE)
+    {
+        g_scanner_rx.dropped += used - SCANNER_DMA_BUF_SIZE;
+        used = SCANNER_DMA_BUF_SIZE;
+    }
+    if (used > g_scanner_rx.high_water)
+    {
+        g_scanner_rx.high_water = used;
+    }
+    __DMB();
+    g_scanner_rx.head += n;
+}
+
+void Scanner_USART_IRQ_Handler(void)
+{
+    uint16_t sr = SCANNER_USARTx->SR;
+
+    USART_Rx_Count_Errors(sr, &g_scanner_err);
+    if (sr & (USART_FLAG_IDLE | USART_FLAG_ORE | USART_FLAG_FE | USART_FLAG_NE))
+    {
+        // 读 SR 后读 DR 清除 IDLE/错误标志 (此时数据已被 DMA 取走，不会丢字节)
+        USART_ReceiveData(SCANNER_USARTx);
+        Scanner_Sync_DMA_Pos();
+    }
+}
+
+void Scanner_DMA_IRQ_Handler(void)
+{
+    if (DMA_GetITStatus(SCANNER_DMA_IT_HT) != RESET)
+    {
+        DMA_ClearITPendingBit(SCANNER_DMA_IT_HT);
+    }
+    if (DMA_GetITStatus(SCANNER_DMA_IT_TC) != RESET)
+    {
+        DMA_ClearITPendingBit(SCANNER_DMA_IT_TC);
+    }
+    Scanner_Sync_DMA_Pos();
+}
+
+uint8_t Scanner_Get_Code(char *code, uint8_t size)
+{
+    const uint8_t *data;
+    uint16_t n, i;
+    uint8_t len;
+
+    // 主循环落后整圈，缓冲区内容已被 DMA 覆盖：整体丢弃，从下一条重新开始
+    if (SPSC_Count(&g_scanner_rx) > SCANNER_DMA_BUF_SIZE)
+    {
+        SPSC_Consume(&g_scanner_rx, SPSC_Count(&g_scanner_rx));
+        g_scanner_code_len = 0;
+        g_scanner_code_overflow = 1;
+        return 0;
+    }
+
+    while ((n = SPSC_Peek_Contig(&g_scanner_rx, &data)) > 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            char ch = (char)data[i];
+
+            if (ch != '\r' && ch != '\n' && ch != '\t')
+            {
+                if (g_scanner_code_len < SCANNER_CODE_MAX)
+                {
+                    g_scanner_code[g_scanner_code_len++] = ch;
+                }
+                else
+                {
+                    g_scanner_code_overflow = 1;
+                }
+                continue;
+            }
+
+            // 结束符：CR LF 连发时第二个结束符得到空条码，直接跳过
+            len = g_scanner_code_len;
+            g_scanner_code_len = 0;
+            if (g_scanner_code_overflow)
+            {
+                g_scanner_code_overflow = 0;
+                g_scanner_truncated++;
+                LOG_W("[Scanner] Code too long or overrun, dropped.\r\n");
+                continue;
+            }
+            if (len == 0)
+            {
+                continue;
+            }
+            if (len > size - 1)
+            {
+                len = size - 1;
+            }
+            memcpy(code, g_scanner_code, len);
+            code[len] = '\0';
+            SPSC_Consume(&g_scanner_rx, i + 1);
+            return len;
+        }
+        SPSC_Consume(&g_scanner_rx, n);
+    }
+    return 0;
+}
+
+void Scanner_Get_Link_Stats(USART_Rx_Stats_t *out)
+{
+    out->dropped = g_scanner_rx.dropped;
+    out->high_water = g_scanner_rx.high_water;
+    out->size = SPSC_Size(&g_scanner_rx);
+    out->overrun = g_scanner_err.overrun;
+    out->framing = g_scanner_err.framing;
+    out->noise = g_scanner_err.noise;
+    out->truncated = g_scanner_truncated;
+}
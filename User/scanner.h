@@ -0,0 +1,45 @@
+#ifndef __SCANNER_H
+#define __SCANNER_H
+
+#include "stm32f10x.h"
+#include "spsc_ring.h"
+#include "bsp_usart_dma.h"
+
+// ==========================================
+// 扫码枪直连串口 (只收不发)
+// ==========================================
+// 条码不再经过上位机转发：DMA 循环接收 + 空闲中断，主循环取出整条条码直接进入扫码队列，
+// 只把 REPORT 异步发给上位机。
+// 注意：USART3_RX 固定在 DMA1 通道 3，与 SPI1_TX (Flash) 冲突，所以用 UART4 (DMA2 通道 3)。
+#define  SCANNER_USARTx                 UART4
+#define  SCANNER_USART_CLK              RCC_APB1Periph_UART4
+#define  SCANNER_USART_APBxClkCmd       RCC_APB1PeriphClockCmd
+#define  SCANNER_USART_BAUDRATE         9600      // 常见扫码枪出厂默认
+
+#define  SCANNER_GPIO_CLK               RCC_APB2Periph_GPIOC
+#define  SCANNER_GPIO_APBxClkCmd        RCC_APB2PeriphClockCmd
+#define  SCANNER_RX_GPIO_PORT           GPIOC
+#define  SCANNER_RX_GPIO_PIN            GPIO_Pin_11
+
+#define  SCANNER_USART_IRQ              UART4_IRQn
+#define  SCANNER_USART_IRQHandler       UART4_IRQHandler
+
+#define  SCANNER_DMA_CLK                RCC_AHBPeriph_DMA2
+#define  SCANNER_DMA_CHANNEL            DMA2_Channel3
+#define  SCANNER_DMA_IRQ                DMA2_Channel3_IRQn
+#define  SCANNER_DMA_IRQHandler         DMA2_Channel3_IRQHandler
+#define  SCANNER_DMA_IT_HT              DMA2_IT_HT3
+#define  SCANNER_DMA_IT_TC              DMA2_IT_TC3
+
+#define  SCANNER_DMA_BUF_SIZE           256       // DMA 循环缓冲区 (必须是 2 的幂)
+#define  SCANNER_CODE_MAX               32        // 单条条码最大长度，超长整条丢弃
+
+void Scanner_Init(void);
+// 取出一条完整条码 (CR/LF/TAB 结尾，不含结束符)，返回长度，0=暂无
+uint8_t Scanner_Get_Code(char *code, uint8_t size);
+void Scanner_Get_Link_Stats(USART_Rx_Stats_t *out);
+// 中断入口 (stm32f10x_it.c)
+void Scanner_USART_IRQ_Handler(void);
+void Scanner_DMA_IRQ_Handler(void);
+
+#endif
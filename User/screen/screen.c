@@ -1,22 +1,133 @@
 #include "./screen/screen.h"
+#include "fmt.h"
+#include "log.h"
+#include <string.h>
 
-// 要发送的商品数据缓冲区
-char* myItems[DATA_BUFFER_VOLUME];
-float myPrices[DATA_BUFFER_VOLUME];
-int myCounts[DATA_BUFFER_VOLUME];
-int totalItems = 3; // 数组长度
-
-// 加载新的商品数据到缓冲区
-// 每次和串口屏交互前，先调用此函数加载最新数据
-void Screen_Load_New_Data(MCU_Product_t* list, int _totalItems){
-	if(_totalItems > DATA_BUFFER_VOLUME) return ;
-	
-	totalItems = _totalItems;
-	for(int i=0; i < totalItems; i++){
-		myItems[i] = list[i].product.name;
-		myPrices[i] = list[i].product.price;
-		myCounts[i] = list[i].num;
-	}
+// 增量刷新：只发送标记为脏的行，shownItems 记录屏幕上有内容的行数 (用于清空多余的行)
+static uint8_t lineDirty[SCREEN_CART_LINES];
+static int shownItems = 0;
+static uint32_t shownTotal = 0;
+static uint8_t totalDirty = 1;
+
+// 行内容缓存：格式化好的 "名称,价格,数量"，购物车第 i 件放在 i % SCREEN_TEXT_CACHE 槽，
+// 相邻两页互不覆盖，来回翻页只需拷贝。数量变化只重写名称之后的部分，名称不用再从 Flash 取
+typedef struct
+{
+    int16_t index;                  // 缓存的购物车下标，-1=空
+    uint8_t nameLen;                // 已格式化的名称部分长度，0=名称未加载
+    uint8_t textLen;                // 整行长度，0=价格/数量需要重新格式化
+    char text[SCREEN_LINE_TEXT_LENGTH];
+} Screen_Line_Cache_t;
+static Screen_Line_Cache_t lineCache[SCREEN_TEXT_CACHE];
+typedef char Screen_Name_Batch_Must_Cover_Window[(CART_NAME_BATCH >= SCREEN_CART_LINES) ? 1 : -1];
+
+// 分页窗口：屏幕第 i 行显示购物车第 firstLine + i 件商品 (firstLine 为 SCREEN_CART_LINES 的倍数)
+static int firstLine = 0;
+static int shownPage = 0;           // 屏幕上页码显示的 "当前页/总页数"，0=未显示
+static int shownPageCount = 0;
+
+// 限帧刷新：renderDirty 表示有待刷新的内容，同一控件的多次写入只保留最后一次
+typedef struct
+{
+    const char *obj;                // 控件名 (字符串常量)，NULL=空闲
+    char text[SCREEN_TEXT_LENGTH];
+    uint8_t dirty;
+} Screen_Text_Slot_t;
+static Screen_Text_Slot_t textSlots[SCREEN_TEXT_SLOTS];
+static uint8_t renderDirty = 1;
+static uint8_t renderBusy = 0;      // 当前帧还有内容等待信用发送
+static uint32_t lastRenderMs = 0;
+static uint32_t renderLostSeen = 0; // 已处理过的丢失指令数
+
+// 屏幕返回帧由 TJC_Poll_Frames() 解码后分发到这里，主循环状态机只读取结果
+static uint8_t screenEvent = 0;     // 旧版单字节事件 (0x01 开始购物 / 0x02 结账 / 0x03 超时)，0=无
+static uint8_t screenPage = 0;      // 屏幕当前页面 (sendme 或页面切换时上报)
+static int selectedLine = -1;       // 触摸选中的购物车行号，-1=未选中
+static Screen_Cart_Op_t cartOp = SCREEN_CART_OP_NONE;   // 待主循环处理的触摸改单请求
+
+static void Screen_On_Legacy(uint8_t type, const uint8_t *data, uint8_t len)
+{
+    screenEvent = data[0];
+}
+
+// 选中购物车第 index 行 (空行取消选中)，行号显示在 t4 提示顾客
+static void Screen_Select_Line(int index)
+{
+    char text[24];
+    char *p;
+
+    if (index >= Cart_Count())
+    {
+        index = -1;
+    }
+    selectedLine = index;
+    if (index < 0)
+    {
+        Screen_Set_Text("t4", "");
+        return;
+    }
+    p = Fmt_Str(text, "line ");
+    p = Fmt_U32(p, (uint32_t)index + 1);
+    p = Fmt_Str(p, " selected");
+    *p = '\0';
+    Screen_Set_Text("t4", text);
+}
+
+static void Screen_On_Touch(uint8_t type, const uint8_t *data, uint8_t len)
+{
+    if (len < 3) return;
+    LOG_D("[HMI] Touch page:%d id:%d %s\r\n", data[0], data[1], data[2] ? "press" : "release");
+
+    // 翻页、改单只响应按下，松开事件忽略
+    if (data[2] != 1) return;
+    if (data[1] == SCREEN_BTN_PAGE_UP)
+    {
+        Screen_Scroll_Page(-1);
+    }
+    else if (data[1] == SCREEN_BTN_PAGE_DOWN)
+    {
+        Screen_Scroll_Page(1);
+    }
+    else if (data[1] >= SCREEN_BTN_LINE_FIRST && data[1] < SCREEN_BTN_LINE_FIRST + SCREEN_CART_LINES)
+    {
+        Screen_Select_Line(firstLine + data[1] - SCREEN_BTN_LINE_FIRST);
+    }
+    else if (selectedLine >= 0)
+    {
+        if (data[1] == SCREEN_BTN_DEC)
+        {
+            cartOp = SCREEN_CART_OP_DEC;
+        }
+        else if (data[1] == SCREEN_BTN_INC)
+        {
+            cartOp = SCREEN_CART_OP_INC;
+        }
+        else if (data[1] == SCREEN_BTN_VOID)
+        {
+            cartOp = SCREEN_CART_OP_VOID;
+        }
+    }
+}
+
+static void Screen_On_Page(uint8_t type, const uint8_t *data, uint8_t len)
+{
+    if (len < 1) return;
+    screenPage = data[0];
+}
+
+static void Screen_On_Return_Code(uint8_t type, const uint8_t *data, uint8_t len)
+{
+    // 应答计数和信用由驱动处理，这里只处理屏幕重启和记录错误码
+    if (type == TJC_RET_INVALID_CMD && len == 2)
+    {
+        // 上电启动帧 (00 00 00 ff ff ff)：屏幕内容已复位，全部重发
+        LOG_I("[HMI] Screen restarted.\r\n");
+        Screen_Mark_All_Dirty();
+    }
+    else if (type != TJC_RET_SUCCESS)
+    {
+        LOG_W("[HMI] Command error code 0x%02X\r\n", type);
+    }
 }
 
 // 1. 配置串口函数 & 串口初始化
@@ -33,102 +144,440 @@ void Screen_Shopping_System_Init(void)
     // 初始化串口屏串口 (通常串口屏默认波特率是 9600 或 115200，这里假设 9600)
     // 根据实际屏幕配置修改波特率
     uart2_init(115200); 
+
+    TJC_Register_Handler(TJC_FRAME_LEGACY, TJC_FRAME_LEGACY, Screen_On_Legacy);
+    TJC_Register_Handler(TJC_FRAME_TOUCH, TJC_FRAME_TOUCH, Screen_On_Touch);
+    TJC_Register_Handler(TJC_FRAME_PAGE, TJC_FRAME_PAGE, Screen_On_Page);
+    TJC_Register_Handler(TJC_FRAME_RET_FIRST, TJC_FRAME_RET_LAST, Screen_On_Return_Code);
+    // 打开屏幕应答，刷新按应答信用发送
+    TJC_Ack_Init();
+
+    // 上电后屏幕内容未知，第一次刷新时全部重发
+    for (int i = 0; i < SCREEN_TEXT_CACHE; i++)
+    {
+        lineCache[i].index = -1;
+    }
+    Screen_Mark_All_Dirty();
     
     // printf("System Init OK\r\n");
 }
 
 // 2. 返回bool，检测是否收到开始购物消息 (0x01)
-// 功能：检查缓冲区是否有数据，如果有且为0x01，则返回 true，否则返回 false
+// 功能：取出最近一个屏幕单字节事件 (消费掉)，为 0x01 则返回 true，否则返回 false
 bool Screen_Check_Start_Shopping_Msg(void)
 {
-    // 检查缓冲区是否有数据
-    if (getRingBuffLenght() > 0)
+    uint8_t data = screenEvent;
+
+    screenEvent = 0;
+    if (data == 0x01)
     {
-        // 读取一个字节
-        uint8_t data = read1BFromRingBuff(0);
-        // 从缓冲区删除这个字节（消费掉）
-        deleteRingBuff(1);
-        
-        // 判断是否为 0x01
-        if (data == 0x01)
+        // printf("Start Shopping Msg Received!\r\n");
+        return true;
+    }
+    return false;
+}
+
+// 购物车第 index 行对应的屏幕行需要重发 (行内容缓存不变)，不在当前窗口内的只更新总价和页码
+static void Screen_Mark_Row_Dirty(int index)
+{
+    index -= firstLine;
+    if (index >= 0 && index < SCREEN_CART_LINES)
+    {
+        lineDirty[index] = 1;
+    }
+    totalDirty = 1;
+    renderDirty = 1;
+}
+
+// 3. 标记购物车第 index 件商品需要重发 (数量变化或新增商品)
+void Screen_Mark_Line_Dirty(int index)
+{
+    Screen_Line_Cache_t *c = &lineCache[index % SCREEN_TEXT_CACHE];
+
+    if (index >= 0 && c->index == index)
+    {
+        c->textLen = 0;
+    }
+    Screen_Mark_Row_Dirty(index);
+}
+
+// 切换窗口：窗口内所有行都要重发，总价不变
+static void Screen_Set_Window(int first)
+{
+    if (first == firstLine)
+    {
+        return;
+    }
+    firstLine = first;
+    memset(lineDirty, 1, sizeof(lineDirty));
+    renderDirty = 1;
+}
+
+// 新加入购物车的商品：扫码时手里已经有名称，直接放进缓存，免得显示时再查 Flash
+void Screen_Cache_Line_Name(int index, const char *name)
+{
+    Screen_Line_Cache_t *c = &lineCache[index % SCREEN_TEXT_CACHE];
+
+    c->index = (int16_t)index;
+    c->nameLen = (uint8_t)(Fmt_Str_Pad(c->text, name, 7) - c->text);
+    c->textLen = 0;
+}
+
+// 翻到购物车第 index 件商品所在的页 (新增商品时让顾客看到刚扫的商品)
+void Screen_Show_Line(int index)
+{
+    if (index < 0)
+    {
+        return;
+    }
+    Screen_Set_Window(index - index % SCREEN_CART_LINES);
+}
+
+// 购物车第 index 行已删除 (Cart_Remove)：后面的行 (原 index+1 .. Cart_Count()) 都前移了一位，
+// 缓存跟着前移，只重发窗口内 index 及之后的行。窗口越界由 Screen_Update_Page 退回末页
+void Screen_Line_Removed(int index)
+{
+    int last = Cart_Count();
+    int k;
+
+    if (lineCache[index % SCREEN_TEXT_CACHE].index == index)
+    {
+        lineCache[index % SCREEN_TEXT_CACHE].index = -1;    // 删掉的商品名称作废
+    }
+    for (k = index + 1; k <= last; k++)
+    {
+        Screen_Line_Cache_t *src = &lineCache[k % SCREEN_TEXT_CACHE];
+
+        if (src->index == k)
         {
-            // printf("Start Shopping Msg Received!\r\n");
-            return true;
+            lineCache[(k - 1) % SCREEN_TEXT_CACHE] = *src;
+            lineCache[(k - 1) % SCREEN_TEXT_CACHE].index = (int16_t)(k - 1);
+            src->index = -1;
         }
     }
-    return false;
+
+    if (selectedLine == index)
+    {
+        Screen_Select_Line(-1);
+    }
+    else if (selectedLine > index)
+    {
+        Screen_Select_Line(selectedLine - 1);
+    }
+    for (k = (index > firstLine) ? index : firstLine; k <= last && k < firstLine + SCREEN_CART_LINES; k++)
+    {
+        Screen_Mark_Row_Dirty(k);
+    }
+    totalDirty = 1;
+    renderDirty = 1;
+}
+
+// 翻页：delta=-1 上一页，1 下一页，越界时停在首页/末页
+void Screen_Scroll_Page(int delta)
+{
+    int first = firstLine + delta * SCREEN_CART_LINES;
+
+    if (first < 0 || first >= Cart_Count())
+    {
+        return;
+    }
+    Screen_Set_Window(first);
+}
+
+// 整个列表重发 (清空购物车、屏幕重新上电、指令丢失等)
+void Screen_Mark_All_Dirty(void)
+{
+    if (selectedLine >= Cart_Count())
+    {
+        selectedLine = -1;  // 购物车已清空
+    }
+    memset(lineDirty, 1, sizeof(lineDirty));
+    // 屏幕上的内容不可信 (可能丢了清空指令)，空行也要重发一次
+    shownItems = SCREEN_CART_LINES;
+    // 名称保留 (新商品加入时会覆盖所在槽位)，价格/数量重新格式化
+    for (int i = 0; i < SCREEN_TEXT_CACHE; i++)
+    {
+        lineCache[i].textLen = 0;
+    }
+    shownPage = 0;
+    totalDirty = 1;
+    renderDirty = 1;
+}
+
+// 窗口内要发送的行如果缓存里没有名称，一次遍历 Flash 批量取回 (翻到较远的页时)
+static void Screen_Load_Window_Names(int itemNum)
+{
+    static char names[CART_NAME_BATCH][CART_NAME_LENGTH];
+    uint8_t lines[CART_NAME_BATCH];
+    uint8_t n = 0;
+
+    for (int i = 0; i < SCREEN_CART_LINES && i < itemNum && n < CART_NAME_BATCH; i++)
+    {
+        int index = firstLine + i;
+
+        if (lineDirty[i] && lineCache[index % SCREEN_TEXT_CACHE].index != index)
+        {
+            lines[n++] = (uint8_t)index;
+        }
+    }
+    if (n == 0)
+    {
+        return;
+    }
+    Cart_Load_Names(lines, n, names);
+    for (uint8_t k = 0; k < n; k++)
+    {
+        Screen_Cache_Line_Name(lines[k], names[k]);
+    }
+}
+
+// 取购物车第 index 件商品的行内容 (名称已由 Screen_Load_Window_Names 载入)，缓存失效时才重新格式化
+static Screen_Line_Cache_t *Screen_Line_Text(int index)
+{
+    Screen_Line_Cache_t *c = &lineCache[index % SCREEN_TEXT_CACHE];
+    const Cart_Line_t *item = Cart_Get_Line(index);
+    char *p;
+
+    if (c->textLen == 0)
+    {
+        // 等同于 "%7s,%07.2f,%07d"，用 fmt.h 直接拼装，不走 vsnprintf / 软件浮点
+        p = c->text + c->nameLen;
+        *p++ = ',';
+        p = Fmt_Price(p, item->price, 4);
+        *p++ = ',';
+        p = Fmt_U32_Pad(p, item->count, 7, '0');
+        c->textLen = (uint8_t)(p - c->text);
+    }
+    return c;
 }
 
-// 3. 接收商品信息并在串口屏 t1 组件显示
-// 参数：names-商品名数组, prices-价格数组, counts-数量数组, itemNum-商品总种类数
+// 4. 把变化的商品行发送到串口屏，每行对应一个文本控件 ln0, ln1 ...
 // 格式：(名字，价格，数量)
-void Screen_Update_HMI_Shopping_List(void)
-{
-    // 1. 先清空 t1 组件的内容
-    TJCPrintf("t1.txt=\"\"");
-    char** names = myItems;
-    float *prices = myPrices;
-    int *counts = myCounts;
-    const int itemNum = totalItems;
-    
-    // 2. 遍历数组，拼接字符串并发送
-    // 注意：由于 TJCPrintf 内部 buffer 只有 100 字节，我们使用追加模式 (t1.txt+=...)
-    // 这样可以避免一次性发送过长字符串导致溢出
-    
-    for(int i = 0; i < itemNum; i++)
+// 只在有应答信用时发送，信用用完返回 false，剩下的脏行留到下次
+bool Screen_Update_HMI_Shopping_List(void)
+{
+    // 只取窗口内的商品，i 为屏幕行号
+    const int itemNum = Cart_Count() - firstLine;
+    char line[SCREEN_CMD_LENGTH];
+    char *p;
+
+    Screen_Load_Window_Names(itemNum);
+
+    for(int i = 0; i < SCREEN_CART_LINES; i++)
     {
-        // 格式化单个商品条目，例如: (Apple, 2.5, 10)\r\n
-        // 使用 t1.txt+= "..." 进行追加
-        TJCPrintf("t1.txt+=\"%7s,%07.2f,%07d\r\n\"", names[i], prices[i], counts[i]);
-        
-        // 简单的延时，防止串口发送太快屏幕处理不过来（可选）
-        for(int k=0; k<5000; k++); 
+        if (!lineDirty[i])
+        {
+            continue;
+        }
+        // 屏幕上本来就是空行，不用再清
+        if (i >= itemNum && i >= shownItems)
+        {
+            lineDirty[i] = 0;
+            continue;
+        }
+        if (TJC_Ack_Credits() == 0)
+        {
+            return false;
+        }
+        lineDirty[i] = 0;
+
+        p = Fmt_Str(line, SCREEN_LINE_OBJ);
+        p = Fmt_U32(p, (uint32_t)i);
+        p = Fmt_Str(p, ".txt=\"");
+        if (i < itemNum)
+        {
+            Screen_Line_Cache_t *c = Screen_Line_Text(firstLine + i);
+
+            memcpy(p, c->text, c->textLen);
+            p += c->textLen;
+        }
+        *p++ = '"';
+        TJC_SendCmd(line, (uint16_t)(p - line));
+    }
+    shownItems = (itemNum < SCREEN_CART_LINES) ? itemNum : SCREEN_CART_LINES;
+    if (shownItems < 0)
+    {
+        shownItems = 0;
     }
+    return true;
 }
 
-// 4. 发送总价给串口屏
-// 功能：计算总价并显示 (假设显示在 t1 的末尾，或者你可以指定其他组件如 t2)
-void Screen_Calculate_And_Send_Total(void)
+// 5. 发送总价给串口屏
+// 功能：计算总价并显示在 t3，总价没变时不重发；没有应答信用时返回 false
+bool Screen_Calculate_And_Send_Total(void)
 {
-    float totalPrice = 0.0f;
-    float* prices = myPrices;
-    int* counts = myCounts;
-    const int itemNum = totalItems;
+    uint32_t totalPrice = Cart_Total(); // 分
 
-    // 计算总价
-    for(int i = 0; i < itemNum; i++)
+    if (!totalDirty && totalPrice == shownTotal)
+    {
+        return true;
+    }
+    if (TJC_Ack_Credits() == 0)
     {
-        totalPrice += prices[i] * counts[i];
+        return false;
     }
+    totalDirty = 0;
+    shownTotal = totalPrice;
     
     // 发送总价，这里示例追加显示在 t3中，也可以改为 t3.txt="..."
-    TJCPrintf("t3.txt=\"%.2f\"", totalPrice);
+    char cmd[SCREEN_CMD_LENGTH];
+    char *p = Fmt_Str(cmd, "t3.txt=\"");
+    p = Fmt_Price(p, totalPrice, 0);
+    *p++ = '"';
+    TJC_SendCmd(cmd, (uint16_t)(p - cmd));
     
-    // printf("Total Price Calculated: %.2f\r\n", totalPrice);
+    // printf("Total Price Calculated: " PRICE_FMT "\r\n", PRICE_ARGS(totalPrice));
+    return true;
 }
 
-// 5. 监听 Pay Off (0x02) 消息
-// 功能：非阻塞等待，直到收到 0x02。如果收到 0x03 则忽略并继续等待。
-bool Screen_Wait_For_PayOff_Msg(void)
+// 6. 设置文本控件内容 (如 t4 提示信息)，在下一帧发送；同一控件连续设置只发最后一次
+// obj 必须是字符串常量，例如 Screen_Set_Text("t4", "shopping finished")
+void Screen_Set_Text(const char *obj, const char *text)
 {
-    uint8_t data;
-    
-    // printf("Waiting for Pay Off (0x02)...\r\n");
-    
-    // 非阻塞轮询：没有数据就直接返回 false，避免把主循环卡死
-    if (getRingBuffLenght() > 0)
+    Screen_Text_Slot_t *slot = NULL;
+
+    for (int i = 0; i < SCREEN_TEXT_SLOTS; i++)
     {
-        data = read1BFromRingBuff(0);
-        deleteRingBuff(1);
+        if (textSlots[i].obj != NULL && strcmp(textSlots[i].obj, obj) == 0)
+        {
+            slot = &textSlots[i];
+            break;
+        }
+        if (textSlots[i].obj == NULL && slot == NULL)
+        {
+            slot = &textSlots[i];
+        }
+    }
+    if (slot == NULL)
+    {
+        // 槽位用完，直接发送
+        TJCPrintf("%s.txt=\"%s\"", obj, text);
+        return;
+    }
+    slot->obj = obj;
+    strncpy(slot->text, text, SCREEN_TEXT_LENGTH - 1);
+    slot->text[SCREEN_TEXT_LENGTH - 1] = '\0';
+    slot->dirty = 1;
+    renderDirty = 1;
+}
 
-        if (data == 0x02)
+// 每帧开始时确定窗口和页码：购物车变短 (清空、删除) 后窗口越界就退回末页
+static void Screen_Update_Page(void)
+{
+    int items = Cart_Count();
+    int pageCount = (items + SCREEN_CART_LINES - 1) / SCREEN_CART_LINES;
+    int page;
+    char text[16];
+    char *p;
+
+    if (pageCount == 0)
+    {
+        pageCount = 1;
+    }
+    if (firstLine >= items)
+    {
+        Screen_Set_Window((pageCount - 1) * SCREEN_CART_LINES);
+    }
+    page = firstLine / SCREEN_CART_LINES + 1;
+    if (page == shownPage && pageCount == shownPageCount)
+    {
+        return;
+    }
+    shownPage = page;
+    shownPageCount = pageCount;
+
+    p = Fmt_U32(text, (uint32_t)page);
+    *p++ = '/';
+    p = Fmt_U32(p, (uint32_t)pageCount);
+    *p = '\0';
+    Screen_Set_Text(SCREEN_PAGE_OBJ, text);
+}
+
+// 发送待刷新的文本控件，没有应答信用时返回 false
+static bool Screen_Send_Texts(void)
+{
+    char cmd[SCREEN_CMD_LENGTH];
+    char *p;
+
+    for (int i = 0; i < SCREEN_TEXT_SLOTS; i++)
+    {
+        if (!textSlots[i].dirty)
+        {
+            continue;
+        }
+        if (TJC_Ack_Credits() == 0)
         {
-            return true;
+            return false;
         }
-        // 其他字节（包括 0x03 超时）在上层用超时机制处理，这里仅消费并忽略
+        textSlots[i].dirty = 0;
+        p = Fmt_Str(cmd, textSlots[i].obj);
+        p = Fmt_Str(p, ".txt=\"");
+        p = Fmt_Str(p, textSlots[i].text);
+        *p++ = '"';
+        TJC_SendCmd(cmd, (uint16_t)(p - cmd));
     }
+    return true;
+}
 
-    return false;
+// 7. 主循环调用：限帧把所有待刷新内容发出去
+// 每条指令等屏幕应答后再发下一批 (TJC_ACK_WINDOW 条以内)，一帧可能跨多次主循环发完，
+// 发送速度由屏幕实际处理能力决定，不再靠固定延时
+void Screen_Render_Task(uint32_t now_ms)
+{
+    // 有指令丢失 (超时无应答或屏幕缓冲区溢出)：不知道丢的是哪条，全部重发
+    if (TJC_Ack_Lost() != renderLostSeen)
+    {
+        renderLostSeen = TJC_Ack_Lost();
+        Screen_Mark_All_Dirty();
+    }
+
+    if (!renderBusy)
+    {
+        if (!renderDirty || (uint32_t)(now_ms - lastRenderMs) < 1000U / SCREEN_MAX_FPS)
+        {
+            return;
+        }
+        lastRenderMs = now_ms;
+        renderDirty = 0;
+        renderBusy = 1;
+        Screen_Update_Page();
+    }
+
+    if (!Screen_Update_HMI_Shopping_List() || !Screen_Calculate_And_Send_Total() || !Screen_Send_Texts())
+    {
+        return;
+    }
+    renderBusy = 0;
+}
+
+// 8. 监听 Pay Off (0x02) 消息
+// 功能：非阻塞，取出最近一个屏幕单字节事件，为 0x02 则返回 true。收到 0x03 则忽略并继续等待。
+bool Screen_Wait_For_PayOff_Msg(void)
+{
+    uint8_t data = screenEvent;
+
+    // 其他事件（包括 0x03 超时）在上层用超时机制处理，这里仅消费并忽略
+    screenEvent = 0;
+    return data == 0x02;
+}
+
+uint8_t Screen_Get_Page(void)
+{
+    return screenPage;
+}
+
+// 取出触摸改单请求 (消费掉)，index 为选中的购物车行号
+Screen_Cart_Op_t Screen_Get_Cart_Op(int *index)
+{
+    Screen_Cart_Op_t op = cartOp;
+
+    cartOp = SCREEN_CART_OP_NONE;
+    if (selectedLine < 0 || selectedLine >= Cart_Count())
+    {
+        return SCREEN_CART_OP_NONE;
+    }
+    *index = selectedLine;
+    return op;
 }
 
 /*
@@ -140,7 +589,7 @@ int main(void)
     
     // 模拟的商品数据
     char *myItems[] = {"Apple", "Banana", "Milk"};
-    float myPrices[] = {5.5, 3.0, 12.0};
+    uint32_t myPrices[] = {550, 300, 1200}; // 分
     int myCounts[] = {2, 5, 1};
     int totalItems = 3; // 数组长度
     
@@ -6,21 +6,59 @@
 #include "stdbool.h"       // 用于 bool 类型
 #include "stdio.h"
 #include "products.h"
+#include "cart.h"
 
-#define FRAME_LENGTH 7
+// 单条串口屏指令缓冲区：ln0.txt="名称(最长 47),价格,数量" 最长约 80 字节
+#define SCREEN_CMD_LENGTH 100
+// 购物车每行一个文本控件 (HMI 工程中 ln0 ~ ln9)，只重发变化的行，扫码一次的屏幕流量与购物车长度无关
+#define SCREEN_LINE_OBJ   "ln"
+#define SCREEN_CART_LINES 10
+// 每件商品预先格式化好的行内容 "名称,价格,数量"：名称最长 47 + 价格最长 11 + 数量最长 10 + 两个逗号
+#define SCREEN_LINE_TEXT_LENGTH 72
+// 行内容缓存槽数：两页，来回翻页都命中 (窗口内的名称一次最多批量取 CART_NAME_BATCH 个)
+#define SCREEN_TEXT_CACHE (2 * SCREEN_CART_LINES)
+// 分页：屏幕只显示购物车中 SCREEN_CART_LINES 行的一个窗口，翻页只重发窗口内的行
+// HMI 工程中翻页按钮的控件 ID (按下时屏幕发 0x65 触摸事件，需勾选"发送键值")，页码显示在 pg 控件
+#define SCREEN_BTN_PAGE_UP   20
+#define SCREEN_BTN_PAGE_DOWN 21
+#define SCREEN_PAGE_OBJ   "pg"
+// 改单：点商品行选中 (ln0 ~ ln9 的控件 ID 依次为 SCREEN_BTN_LINE_FIRST 起，同样需勾选"发送键值")，
+// 再点减一/加一/删除行按钮修改选中的商品，选中的行号显示在 t4
+#define SCREEN_BTN_LINE_FIRST 30
+#define SCREEN_BTN_DEC    22
+#define SCREEN_BTN_INC    23
+#define SCREEN_BTN_VOID   24
+// 限帧刷新：改动只做标记，主循环 Screen_Render_Task() 每秒最多刷新 SCREEN_MAX_FPS 次，
+// 每帧按屏幕应答信用发送，上一帧还没发完时继续合并，屏幕只收到最新状态
+#define SCREEN_MAX_FPS    10
+#define SCREEN_TEXT_SLOTS 4     // Screen_Set_Text 可合并的控件数
+#define SCREEN_TEXT_LENGTH 48
 
-// 购物车数据
-extern char* myItems[DATA_BUFFER_VOLUME];
-extern float myPrices[DATA_BUFFER_VOLUME];
-extern int myCounts[DATA_BUFFER_VOLUME];
-extern int totalItems;
+// 触摸改单请求，主循环取出后修改购物车 (与协议 CMD:CART_* 走同一套处理)
+typedef enum
+{
+    SCREEN_CART_OP_NONE = 0,
+    SCREEN_CART_OP_DEC,     // 数量减一，减到 0 删除该行
+    SCREEN_CART_OP_INC,     // 数量加一
+    SCREEN_CART_OP_VOID     // 删除整行
+} Screen_Cart_Op_t;
 
-void Screen_Load_New_Data(MCU_Product_t* list, int _totalItems);
+// 购物车数据直接从 cart.h 读取
 void Screen_Shopping_System_Init(void);
 bool Screen_Check_Start_Shopping_Msg(void);
-void Screen_Update_HMI_Shopping_List(void);
-void Screen_Calculate_And_Send_Total(void);
+void Screen_Mark_Line_Dirty(int index);
+void Screen_Mark_All_Dirty(void);
+void Screen_Show_Line(int index);
+void Screen_Line_Removed(int index);
+void Screen_Cache_Line_Name(int index, const char *name);
+void Screen_Scroll_Page(int delta);
+bool Screen_Update_HMI_Shopping_List(void);
+bool Screen_Calculate_And_Send_Total(void);
+void Screen_Set_Text(const char *obj, const char *text);
+void Screen_Render_Task(uint32_t now_ms);
 bool Screen_Wait_For_PayOff_Msg(void);
+uint8_t Screen_Get_Page(void);
+Screen_Cart_Op_t Screen_Get_Cart_Op(int *index);
 
 
 
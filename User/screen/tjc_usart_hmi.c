@@ -10,15 +10,30 @@
 
 #define STR_LENGTH 100
 
-typedef struct
-{
-	uint16_t Head;
-	uint16_t Tail;
-	uint16_t Lenght;
-	uint8_t  Ring_data[RINGBUFF_LEN];
-}RingBuff_t;
-
-RingBuff_t ringBuff;	//创建一个ringBuff的缓冲区
+static uint8_t ringBuffData[RINGBUFF_LEN];
+SPSC_Ring_t ringBuff;	//屏幕接收缓冲区：USART2 中断写入，主循环读取，无需关中断
+static USART_Rx_Errors_t ringBuffErr;	//USART2 接收错误计数
+
+//屏幕发送环形缓冲区：整条指令 (含 0xff 0xff 0xff) 写入后立即返回，由 DMA1 通道 7 在后台发出
+static uint8_t tjcTxBuf[TJC_TX_RING_SIZE];
+static volatile uint16_t tjcTxHead = 0;		//写入位置 (主循环推进)
+static volatile uint16_t tjcTxTail = 0;		//发送位置 (DMA 完成中断推进)
+static volatile uint16_t tjcTxDmaLen = 0;	//正在传输的字节数，0=DMA 空闲
+static volatile uint32_t tjcTxDropped = 0;	//中断中缓冲区满丢弃的字节数
+
+//应答流控：按发送顺序记录每条指令的发送时间，屏幕按顺序回应答
+static uint32_t tjcAckSentMs[TJC_ACK_FIFO];
+static uint16_t tjcAckHead = 0;
+static uint16_t tjcAckTail = 0;
+static uint8_t tjcAckEnabled = 0;		//bkcmd=3 已发出
+static uint8_t tjcAckConfirmed = 0;		//发出 bkcmd=3 后收到过应答，说明屏幕已打开应答
+static uint32_t tjcAckInitMs = 0;		//发出 bkcmd=3 的时间
+static uint32_t tjcNowMs = 0;			//TJC_Poll_Frames 更新的时间戳，用于记录发送时间
+static uint32_t tjcAckRateStartMs = 0;
+static uint16_t tjcAckRateCount = 0;
+static TJC_Ack_Stats_t tjcAck;
+
+static void TJC_TX_DMA_Config(void);
 
 
 /********************************************************
@@ -140,6 +155,177 @@ void uart2_init(uint32_t __Baud)
 	NVIC_InitStructure.NVIC_IRQChannelCmd                 = ENABLE;//确定使能
 	NVIC_Init(&NVIC_InitStructure);//初始化配置此中断通道
 		
+	TJC_TX_DMA_Config();//发送走 DMA
+}
+
+
+
+/********************************************************
+函数名：  	TJC_TX_DMA_Config
+功能：    	配置 USART2 TX DMA (内存 -> USART2->DR)，每段传输完成后在中断中接续下一段
+**********************************************************/
+static void TJC_TX_DMA_Config(void)
+{
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+	DMA_DeInit(TJC_TX_DMA_CHANNEL);
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&USART2->DR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)tjcTxBuf;	//每次启动前重新设置
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Low;	//低于 SPI Flash 的 DMA
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init(TJC_TX_DMA_CHANNEL, &DMA_InitStructure);
+	DMA_ITConfig(TJC_TX_DMA_CHANNEL, DMA_IT_TC, ENABLE);
+
+	NVIC_InitStructure.NVIC_IRQChannel                    = TJC_TX_DMA_IRQ;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority  = 1;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority         = 3;
+	NVIC_InitStructure.NVIC_IRQChannelCmd                 = ENABLE;
+	NVIC_Init(&NVIC_InitStructure);
+
+	USART_DMACmd(USART2, USART_DMAReq_Tx, ENABLE);
+}
+
+
+
+/********************************************************
+函数名：  	TJC_TX_Kick
+功能：    	DMA 空闲时启动一段连续内存的传输 (调用方需已关中断或处于 DMA 中断中)
+**********************************************************/
+static void TJC_TX_Kick(void)
+{
+	uint16_t len;
+
+	if (tjcTxDmaLen != 0 || tjcTxHead == tjcTxTail)
+	{
+		return;
+	}
+	len = (tjcTxHead > tjcTxTail) ? (tjcTxHead - tjcTxTail) : (TJC_TX_RING_SIZE - tjcTxTail);
+	tjcTxDmaLen = len;
+
+	TJC_TX_DMA_CHANNEL->CMAR = (uint32_t)&tjcTxBuf[tjcTxTail];
+	DMA_SetCurrDataCounter(TJC_TX_DMA_CHANNEL, len);
+	DMA_Cmd(TJC_TX_DMA_CHANNEL, ENABLE);
+}
+
+
+
+/********************************************************
+函数名：  	TJC_TX_Copy
+功能：    	拷贝到发送缓冲区，分两段处理回绕 (调用方已确认空间并关中断)
+**********************************************************/
+static void TJC_TX_Copy(const uint8_t *data, uint16_t len)
+{
+	uint16_t first = TJC_TX_RING_SIZE - tjcTxHead;
+
+	if (first > len)
+	{
+		first = len;
+	}
+	memcpy(&tjcTxBuf[tjcTxHead], data, first);
+	memcpy(tjcTxBuf, data + first, len - first);
+	tjcTxHead = (tjcTxHead + len) & (TJC_TX_RING_SIZE - 1);
+}
+
+
+
+/********************************************************
+函数名：  	TJC_TX_Write
+功能：    	整条写入发送缓冲区后立即返回，不会只发半条指令
+		  	空间不足时主循环中等待 DMA 腾出空间；中断中或关中断时整条丢弃
+输入参数：	data-数据 len-长度 terminate-1:在末尾补结束符 0xff 0xff 0xff
+返回值： 		1:已入队 0:丢弃
+**********************************************************/
+uint8_t TJC_TX_Write(const uint8_t *data, uint16_t len, uint8_t terminate)
+{
+	static const uint8_t end[3] = {0xff, 0xff, 0xff};
+	uint16_t total = len + (terminate ? sizeof(end) : 0);
+	uint32_t primask = __get_PRIMASK();
+
+	if (total > TJC_TX_RING_SIZE - 1)	//比整个缓冲区还长，永远放不下
+	{
+		tjcTxDropped += total;
+		return 0;
+	}
+
+	while (1)
+	{
+		__disable_irq();
+		if ((uint16_t)(TJC_TX_RING_SIZE - 1 - ((tjcTxHead - tjcTxTail) & (TJC_TX_RING_SIZE - 1))) >= total)
+		{
+			TJC_TX_Copy(data, len);
+			if (terminate)
+			{
+				TJC_TX_Copy(end, sizeof(end));
+			}
+			TJC_TX_Kick();
+			__set_PRIMASK(primask);
+			return 1;
+		}
+		__set_PRIMASK(primask);
+
+		//中断里或关中断时等待会死锁，只能丢弃
+		if (primask != 0 || (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0)
+		{
+			tjcTxDropped += total;
+			return 0;
+		}
+	}
+}
+
+
+
+/********************************************************
+函数名：  	TJC_TX_Flush
+功能：    	等待发送缓冲区中的数据全部移出串口
+**********************************************************/
+void TJC_TX_Flush(void)
+{
+	while (tjcTxHead != tjcTxTail || tjcTxDmaLen != 0);
+	while (USART_GetFlagStatus(USART2, USART_FLAG_TC) == RESET);
+}
+
+
+
+uint32_t TJC_TX_Get_Dropped(void)
+{
+	return tjcTxDropped;
+}
+
+
+
+//发送缓冲区中尚未发完的字节数 (含 DMA 正在传输的部分)
+uint16_t TJC_TX_Pending(void)
+{
+	return (tjcTxHead - tjcTxTail) & (TJC_TX_RING_SIZE - 1);
+}
+
+
+
+/********************************************************
+函数名：  	DMA1_Channel7_IRQHandler
+功能：    	USART2 TX DMA 传输完成：释放已发送的数据并接续下一段
+**********************************************************/
+void DMA1_Channel7_IRQHandler(void)
+{
+	if (DMA_GetITStatus(TJC_TX_DMA_IT_TC) != RESET)
+	{
+		DMA_ClearITPendingBit(TJC_TX_DMA_IT_TC);
+		DMA_Cmd(TJC_TX_DMA_CHANNEL, DISABLE);
+
+		tjcTxTail = (tjcTxTail + tjcTxDmaLen) & (TJC_TX_RING_SIZE - 1);
+		tjcTxDmaLen = 0;
+		TJC_TX_Kick();
+	}
 }
 
 /********************************************************
@@ -153,14 +339,7 @@ void uart2_init(uint32_t __Baud)
 **********************************************************/
 void TJC_SendData(uint8_t *data, uint16_t len)
 {
-	while(len--)
-	{
-		//等待发送数据寄存器为空
-		
-		USART_SendData(USART2, *data++);
-		while(USART_GetFlagStatus(USART2, USART_FLAG_TXE) == RESET);
-	}
-
+	TJC_TX_Write(data, len, 0);	//入队后立即返回，由 DMA 发送
 }
 
 
@@ -180,25 +359,44 @@ void TJCPrintf(const char *str, ...)
 {
 
 
-	uint8_t end = 0xff;
 	char buffer[STR_LENGTH+1];  // 数据长度
 	va_list arg_ptr;
 	va_start(arg_ptr, str);
 	int len = vsnprintf(buffer, STR_LENGTH+1, str, arg_ptr);
 	va_end(arg_ptr);
-	for(int i = 0; i < len; i++)
+	if(len > STR_LENGTH)
 	{
-		USART_SendData(USART2, buffer[i]);
-		while(USART_GetFlagStatus(USART2, USART_FLAG_TXE) == RESET);	//等待发送完毕
+		len = STR_LENGTH;
 	}
+	TJC_SendCmd(buffer, len);
 
-	USART_SendData(USART2, end);			//这个函数改为你的单片机的串口发送单字节函数
-	while(USART_GetFlagStatus(USART2, USART_FLAG_TXE) == RESET);	//等待发送完毕
-	USART_SendData(USART2, end);			//这个函数改为你的单片机的串口发送单字节函数
-	while(USART_GetFlagStatus(USART2, USART_FLAG_TXE) == RESET);	//等待发送完毕
-	USART_SendData(USART2, end);			//这个函数改为你的单片机的串口发送单字节函数
-	while(USART_GetFlagStatus(USART2, USART_FLAG_TXE) == RESET);	//等待发送完毕
+}
 
+
+
+/********************************************************
+函数名：  	TJC_SendCmd
+作者：
+日期：
+功能：    	发送一条已拼装好的指令并补上结束符 0xff 0xff 0xff
+		  	(配合 fmt.h 使用，热路径上代替 TJCPrintf 的 vsnprintf)
+输入参数：	cmd-指令内容(不含结束符) len-长度
+返回值： 		void
+修改记录：
+**********************************************************/
+void TJC_SendCmd(const char *cmd, uint16_t len)
+{
+	//整条指令连同结束符入队，立即返回
+	if (TJC_TX_Write((const uint8_t *)cmd, len, 1) && tjcAckEnabled)
+	{
+		//记录满了就不再跟踪 (只会发生在大量绕过信用直接发送时)
+		if ((uint16_t)(tjcAckHead - tjcAckTail) < TJC_ACK_FIFO)
+		{
+			tjcAckSentMs[tjcAckHead & (TJC_ACK_FIFO - 1)] = tjcNowMs;
+			tjcAckHead++;
+			tjcAck.sent++;
+		}
+	}
 }
 
 
@@ -213,10 +411,8 @@ void TJCPrintf(const char *str, ...)
 **********************************************************/
 void initRingBuff(void)
 {
-  //初始化相关信息
-  ringBuff.Head = 0;
-  ringBuff.Tail = 0;
-  ringBuff.Lenght = 0;
+  //初始化相关信息 (仅在串口中断开启前调用)
+  SPSC_Init(&ringBuff, ringBuffData, RINGBUFF_LEN);
 }
 
 
@@ -233,14 +429,7 @@ void initRingBuff(void)
 **********************************************************/
 void writeRingBuff(uint8_t data)
 {
-  if(ringBuff.Lenght >= RINGBUFF_LEN) //判断缓冲区是否已满
-  {
-    return ;
-  }
-  ringBuff.Ring_data[ringBuff.Tail]=data;
-  ringBuff.Tail = (ringBuff.Tail+1)%RINGBUFF_LEN;//防止越界非法访问
-  ringBuff.Lenght++;
-
+  SPSC_Put(&ringBuff, data); //缓冲区已满时丢弃
 }
 
 
@@ -256,24 +445,7 @@ void writeRingBuff(uint8_t data)
 **********************************************************/
 void deleteRingBuff(uint16_t size)
 {
-	if(size >= ringBuff.Lenght)
-	{
-	    initRingBuff();
-	    return;
-	}
-	for(int i = 0; i < size; i++)
-	{
-
-		if(ringBuff.Lenght == 0)//判断非空
-		{
-		initRingBuff();
-		return;
-		}
-		ringBuff.Head = (ringBuff.Head+1)%RINGBUFF_LEN;//防止越界非法访问
-		ringBuff.Lenght--;
-
-	}
-
+	SPSC_Consume(&ringBuff, size); //直接移动读指针，超过数据量时清空
 }
 
 
@@ -289,9 +461,7 @@ void deleteRingBuff(uint16_t size)
 **********************************************************/
 uint8_t read1BFromRingBuff(uint16_t position)
 {
-	uint16_t realPosition = (ringBuff.Head + position) % RINGBUFF_LEN;
-
-	return ringBuff.Ring_data[realPosition];
+	return SPSC_Peek(&ringBuff, position);
 }
 
 
@@ -308,7 +478,7 @@ uint8_t read1BFromRingBuff(uint16_t position)
 **********************************************************/
 uint16_t getRingBuffLenght()
 {
-	return ringBuff.Lenght;
+	return SPSC_Count(&ringBuff);
 }
 
 
@@ -323,7 +493,307 @@ uint16_t getRingBuffLenght()
 **********************************************************/
 uint8_t isRingBuffOverflow()
 {
-	return ringBuff.Lenght == RINGBUFF_LEN;
+	return SPSC_Count(&ringBuff) == RINGBUFF_LEN;
+}
+
+
+/********************************************************
+函数名：  	TJC 返回帧解码
+功能：    	在主循环中从接收缓冲区拼帧，按帧类型分发给注册的处理函数
+		  	0x71/0x67/0x68 帧的数据中可能出现 0xff，按固定长度判断结尾
+**********************************************************/
+typedef struct
+{
+	uint8_t first;
+	uint8_t last;
+	TJC_Frame_Handler_t handler;
+} TJC_Handler_Entry_t;
+
+static TJC_Handler_Entry_t tjcHandlers[TJC_HANDLER_MAX];
+static uint8_t tjcHandlerCount = 0;
+static uint8_t tjcFrame[TJC_FRAME_MAX];
+static uint8_t tjcFrameLen = 0;
+static uint32_t tjcFrameLastMs = 0;		//最后收到字节的时间
+static uint32_t tjcFrameErrors = 0;		//超长、超时被丢弃的半帧数
+
+
+
+
+/********************************************************
+函数名：  	TJC_Register_Handler
+功能：    	注册帧类型 first~last 的处理函数
+返回值： 		1:成功 0:表已满
+**********************************************************/
+uint8_t TJC_Register_Handler(uint8_t first, uint8_t last, TJC_Frame_Handler_t handler)
+{
+	if (tjcHandlerCount >= TJC_HANDLER_MAX)
+	{
+		return 0;
+	}
+	tjcHandlers[tjcHandlerCount].first = first;
+	tjcHandlers[tjcHandlerCount].last = last;
+	tjcHandlers[tjcHandlerCount].handler = handler;
+	tjcHandlerCount++;
+	return 1;
+}
+
+
+
+static void TJC_Dispatch(uint8_t type, const uint8_t *data, uint8_t len)
+{
+	for (uint8_t i = 0; i < tjcHandlerCount; i++)
+	{
+		if (type >= tjcHandlers[i].first && type <= tjcHandlers[i].last)
+		{
+			tjcHandlers[i].handler(type, data, len);
+		}
+	}
+}
+
+
+
+//固定长度的帧 (数据里可能有 0xff)，返回 0 表示以结束符判断
+static uint8_t TJC_Frame_Fixed_Length(uint8_t type)
+{
+	switch (type)
+	{
+	case TJC_FRAME_NUMBER:
+		return 1 + 4 + 3;
+	case TJC_FRAME_XY:
+	case TJC_FRAME_XY_SLEEP:
+		return 1 + 5 + 3;
+	default:
+		return 0;
+	}
+}
+
+
+
+/********************************************************
+函数名：  	TJC_Ack_Init
+功能：    	打开屏幕的应答 (bkcmd=3：成功和失败都返回)，之后 TJC_SendCmd 发出的指令都等待应答
+		  	屏幕重新上电会恢复默认 bkcmd，收到启动帧时自动重新调用
+**********************************************************/
+void TJC_Ack_Init(void)
+{
+	static const char cmd[] = "bkcmd=3";
+
+	//bkcmd 本身是否有应答取决于屏幕原来的设置，不计入跟踪；
+	//在它的应答到达 (或超时) 之前不给信用，否则它的应答会被算到后面的指令上，掩盖一次丢失
+	tjcAckEnabled = 0;
+	tjcAckConfirmed = 0;
+	tjcAckTail = tjcAckHead;
+	tjcAckInitMs = tjcNowMs;
+	TJC_SendCmd(cmd, sizeof(cmd) - 1);
+	tjcAckEnabled = 1;
+}
+
+
+
+/********************************************************
+函数名：  	TJC_Ack_Credits
+功能：    	当前还能发送的指令条数，调用方按信用发送即可跟上屏幕的实际处理速度
+返回值： 		0 表示需要等待应答
+**********************************************************/
+uint8_t TJC_Ack_Credits(void)
+{
+	uint16_t inflight = tjcAckHead - tjcAckTail;
+
+	if (!tjcAckEnabled)
+	{
+		return TJC_ACK_WINDOW;
+	}
+	if (!tjcAckConfirmed && (uint32_t)(tjcNowMs - tjcAckInitMs) < TJC_ACK_TIMEOUT_MS)
+	{
+		return 0;		//等待 bkcmd=3 的应答
+	}
+	return (inflight >= TJC_ACK_WINDOW) ? 0 : (uint8_t)(TJC_ACK_WINDOW - inflight);
+}
+
+
+
+//累计丢失的指令数，上层发现变化时需要重发 (无法知道丢的是哪一条)
+uint32_t TJC_Ack_Lost(void)
+{
+	return tjcAck.lost;
+}
+
+
+
+void TJC_Get_Ack_Stats(TJC_Ack_Stats_t *out)
+{
+	*out = tjcAck;
+	out->inflight = tjcAckHead - tjcAckTail;
+}
+
+
+
+//收到返回码：对应最早一条未应答的指令
+static void TJC_Ack_Frame(uint8_t type, uint8_t len)
+{
+	if (type == TJC_RET_INVALID_CMD && len == 2)
+	{
+		//启动帧：屏幕重新上电，之前的指令全部作废，重新打开应答
+		TJC_Ack_Init();
+		return;
+	}
+	if (tjcAckTail == tjcAckHead)
+	{
+		//没有等待中的指令：bkcmd=3 自身的应答，屏幕已打开应答
+		if (type == TJC_RET_SUCCESS)
+		{
+			tjcAckConfirmed = 1;
+		}
+		return;
+	}
+	tjcAckTail++;
+	tjcAckConfirmed = 1;
+
+	if (type == TJC_RET_SUCCESS)
+	{
+		tjcAck.ok++;
+		tjcAckRateCount++;
+	}
+	else if (type == TJC_RET_BUFFER_OVERFLOW)
+	{
+		tjcAck.lost++;
+	}
+	else
+	{
+		tjcAck.err++;
+	}
+}
+
+
+
+//最早一条指令超时未应答：视为丢失，收回信用
+static void TJC_Ack_Check_Timeout(uint32_t now_ms)
+{
+	uint32_t lost = tjcAck.lost;
+
+	while (tjcAckTail != tjcAckHead &&
+	       (uint32_t)(now_ms - tjcAckSentMs[tjcAckTail & (TJC_ACK_FIFO - 1)]) >= TJC_ACK_TIMEOUT_MS)
+	{
+		tjcAckTail++;
+		tjcAck.lost++;
+	}
+	//一条应答都没收到过：可能 bkcmd=3 本身丢了，重发一次
+	if (tjcAck.lost != lost && !tjcAckConfirmed)
+	{
+		TJC_Ack_Init();
+	}
+
+	if ((uint32_t)(now_ms - tjcAckRateStartMs) >= 1000)
+	{
+		tjcAck.rate = tjcAckRateCount;
+		tjcAckRateCount = 0;
+		tjcAckRateStartMs = now_ms;
+	}
+}
+
+
+
+/********************************************************
+函数名：  	TJC_Poll_Frames
+功能：    	取出接收缓冲区中的数据拼帧并分发，主循环中调用
+输入参数：		now_ms:当前毫秒时间戳 (用于半帧超时与旧版单字节事件识别)
+**********************************************************/
+void TJC_Poll_Frames(uint32_t now_ms)
+{
+	const uint8_t *data;
+	uint16_t n, i;
+
+	tjcNowMs = now_ms;
+
+	//半帧超时：旧版 HMI 的单字节事件没有结束符，只能靠超时识别；其余按错误丢弃
+	if (tjcFrameLen > 0 && getRingBuffLenght() == 0 && (uint32_t)(now_ms - tjcFrameLastMs) >= TJC_FRAME_TIMEOUT_MS)
+	{
+		if (tjcFrameLen == 1)
+		{
+			TJC_Dispatch(TJC_FRAME_LEGACY, tjcFrame, 1);
+		}
+		else
+		{
+			tjcFrameErrors++;
+		}
+		tjcFrameLen = 0;
+	}
+
+	while ((n = SPSC_Peek_Contig(&ringBuff, &data)) > 0)
+	{
+		tjcFrameLastMs = now_ms;
+		for (i = 0; i < n; i++)
+		{
+			uint8_t fixed;
+
+			if (tjcFrameLen >= TJC_FRAME_MAX)
+			{
+				tjcFrameErrors++;
+				tjcFrameLen = 0;
+			}
+			//返回码 0x01~0x24 后面一定是结束符；紧跟着的不是 0xff，说明前一个字节是旧版单字节事件，
+			//后面的数据已是下一帧 (0x00 除外：启动帧 00 00 00 ff ff ff 本身就带数据)
+			if (tjcFrameLen == 1 && tjcFrame[0] > TJC_RET_INVALID_CMD && tjcFrame[0] <= TJC_FRAME_RET_LAST &&
+			    data[i] != 0xff)
+			{
+				TJC_Dispatch(TJC_FRAME_LEGACY, tjcFrame, 1);
+				tjcFrameLen = 0;
+			}
+			tjcFrame[tjcFrameLen++] = data[i];
+
+			fixed = TJC_Frame_Fixed_Length(tjcFrame[0]);
+			if (fixed != 0 && tjcFrameLen < fixed)
+			{
+				continue;
+			}
+			if (tjcFrameLen >= 4 && tjcFrame[tjcFrameLen - 1] == 0xff &&
+			    tjcFrame[tjcFrameLen - 2] == 0xff && tjcFrame[tjcFrameLen - 3] == 0xff)
+			{
+				if (tjcFrame[0] <= TJC_FRAME_RET_LAST)
+				{
+					TJC_Ack_Frame(tjcFrame[0], tjcFrameLen - 4);
+				}
+				TJC_Dispatch(tjcFrame[0], &tjcFrame[1], tjcFrameLen - 4);
+				tjcFrameLen = 0;
+			}
+			else if (fixed != 0)
+			{
+				//固定长度到了却没有结束符，说明失步
+				tjcFrameErrors++;
+				tjcFrameLen = 0;
+			}
+		}
+		SPSC_Consume(&ringBuff, n);
+	}
+
+	//先处理完已收到的应答再判断超时
+	TJC_Ack_Check_Timeout(now_ms);
+}
+
+
+
+uint32_t TJC_Get_Frame_Errors(void)
+{
+	return tjcFrameErrors;
+}
+
+
+
+/********************************************************
+函数名：  	getRingBuffStats
+功能：    	获取屏幕串口接收统计 (CMD:LINK_STATS)
+输入参数：		out:统计快照
+返回值： 		void
+**********************************************************/
+void getRingBuffStats(USART_Rx_Stats_t *out)
+{
+	out->dropped = ringBuff.dropped;
+	out->high_water = ringBuff.high_water;
+	out->size = SPSC_Size(&ringBuff);
+	out->overrun = ringBuffErr.overrun;
+	out->framing = ringBuffErr.framing;
+	out->noise = ringBuffErr.noise;
+	out->truncated = 0;
 }
 
 
@@ -367,6 +837,7 @@ void _sys_exit(int x)
 /******** 串口2 中断服务函数 ***********/
 void USART2_IRQHandler(void)
 {
+	USART_Rx_Count_Errors(USART2->SR, &ringBuffErr);	//先读 SR 记录错误，随后读 DR 即清除
 	if(USART_GetITStatus(USART2, USART_IT_RXNE) == SET)//判断是不是真的有中断发生
 	{
 		//USART_SendData(USART2,USART_ReceiveData(USART2));//又将数据发回去(用于验证)
@@ -7,6 +7,8 @@
 
  
 #include "stm32f10x.h"
+#include "spsc_ring.h"
+#include "bsp_usart_dma.h"
  
  
  
@@ -14,6 +16,7 @@
 void uart1_init(uint32_t __Baud);
 void uart2_init(uint32_t __Baud);
 void USART2_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
 void TJC_SendData(uint8_t *data, uint16_t len);
  
  
@@ -26,15 +29,73 @@ void TJC_SendData(uint8_t *data, uint16_t len);
 	打印到屏幕串口
 */
 void TJCPrintf(const char *cmd, ...);
+void TJC_SendCmd(const char *cmd, uint16_t len);
+uint8_t TJC_TX_Write(const uint8_t *data, uint16_t len, uint8_t terminate);
+void TJC_TX_Flush(void);
+uint32_t TJC_TX_Get_Dropped(void);
+uint16_t TJC_TX_Pending(void);
 void initRingBuff(void);
 void writeRingBuff(uint8_t data);
 void deleteRingBuff(uint16_t size);
 uint16_t getRingBuffLenght(void);
 uint8_t read1BFromRingBuff(uint16_t position);
+uint8_t isRingBuffOverflow(void);
+void getRingBuffStats(USART_Rx_Stats_t *out);
 
 
 
-#define RINGBUFF_LEN	(500)     //定义最大接收字节数 500
+#define RINGBUFF_LEN	(512)     //定义最大接收字节数 512 (必须是 2 的幂)
+
+//发送：DMA1 通道 7 固定对应 USART2_TX
+#define TJC_TX_RING_SIZE	(1024)    //发送缓冲区，必须是 2 的幂，可容纳约 30 行购物车指令
+#define TJC_TX_DMA_CHANNEL	DMA1_Channel7
+#define TJC_TX_DMA_IRQ		DMA1_Channel7_IRQn
+#define TJC_TX_DMA_IT_TC	DMA1_IT_TC7
+
+//返回帧解码：TJC 返回数据以 0xff 0xff 0xff 结尾，帧类型见第一个字节
+#define TJC_FRAME_MAX		64		//单帧最大长度 (含类型与结束符)，超长丢弃重新同步
+#define TJC_FRAME_TIMEOUT_MS	20		//半帧超过该时间没有后续字节即丢弃
+#define TJC_HANDLER_MAX		8		//可注册的处理函数个数
+
+#define TJC_FRAME_RET_FIRST	0x00		//指令执行结果 / 错误码 0x00~0x24 (bkcmd 控制是否返回)
+#define TJC_FRAME_RET_LAST	0x24
+#define TJC_RET_INVALID_CMD	0x00		//无效指令；带 2 字节 0x00 数据时为上电启动帧
+#define TJC_RET_SUCCESS		0x01
+#define TJC_RET_BUFFER_OVERFLOW	0x24		//屏幕串口指令缓冲区溢出，指令被丢弃
+#define TJC_FRAME_TOUCH		0x65		//控件触摸事件：页面 控件 事件(1按下/0松开)
+#define TJC_FRAME_PAGE		0x66		//当前页面号
+#define TJC_FRAME_XY		0x67		//触摸坐标 (x2 y2 事件)，0x68 为睡眠唤醒时的坐标
+#define TJC_FRAME_XY_SLEEP	0x68
+#define TJC_FRAME_STRING	0x70		//get 返回的字符串
+#define TJC_FRAME_NUMBER	0x71		//get 返回的数值 (int32 小端)
+#define TJC_FRAME_LEGACY	0xFE		//旧版 HMI 程序的单字节事件 (printh 01 等，没有结束符)，超时或下一个字节不是 0xff 时识别
+
+//data/len 不含帧类型和结束符；LEGACY 帧的 data[0] 为收到的那个字节
+typedef void (*TJC_Frame_Handler_t)(uint8_t type, const uint8_t *data, uint8_t len);
+
+uint8_t TJC_Register_Handler(uint8_t first, uint8_t last, TJC_Frame_Handler_t handler);
+void TJC_Poll_Frames(uint32_t now_ms);
+uint32_t TJC_Get_Frame_Errors(void);
+
+//应答流控：bkcmd=3 时屏幕对每条指令都回一个返回码 (0x01 成功，其余为错误码)，按应答发放信用
+#define TJC_ACK_WINDOW		4		//最多同时未应答的指令数 (屏幕串口指令缓冲区约 1KB，单条最长约 100 字节)
+#define TJC_ACK_FIFO		16		//发送时间记录深度，绕过信用直接发送的指令也能对上应答 (必须是 2 的幂)
+#define TJC_ACK_TIMEOUT_MS	200		//超过该时间没有应答视为指令丢失
+
+typedef struct
+{
+	uint32_t sent;		//已发送并等待应答的指令总数
+	uint32_t ok;		//返回成功
+	uint32_t err;		//返回错误码 (指令格式、控件名错误等)
+	uint32_t lost;		//超时未应答或屏幕缓冲区溢出 (0x24)
+	uint16_t inflight;	//当前未应答数
+	uint16_t rate;		//上一秒屏幕实际确认的指令数 (条/秒)
+} TJC_Ack_Stats_t;
+
+void TJC_Ack_Init(void);
+uint8_t TJC_Ack_Credits(void);
+uint32_t TJC_Ack_Lost(void);
+void TJC_Get_Ack_Stats(TJC_Ack_Stats_t *out);
 
 #define usize getRingBuffLenght()
 #define code_c() initRingBuff()
@@ -0,0 +1,65 @@
+#include "spsc_ring.h"
+#include <string.h>
+
+void SPSC_Init(SPSC_Ring_t *ring, uint8_t *buf, uint16_t size)
+{
+    ring->buf = buf;
+    ring->mask = size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->high_water = 0;
+    ring->dropped = 0;
+}
+
+uint8_t SPSC_Peek(const SPSC_Ring_t *ring, uint16_t offset)
+{
+    uint8_t byte;
+
+    __DMB(); // 先看到 head，再读数据
+    byte = ring->buf[(uint16_t)(ring->tail + offset) & ring->mask];
+    return byte;
+}
+
+uint16_t SPSC_Peek_Contig(const SPSC_Ring_t *ring, const uint8_t **data)
+{
+    uint16_t count = SPSC_Count(ring);
+    uint16_t start = ring->tail & ring->mask;
+    uint16_t to_end = ring->mask + 1 - start;
+
+    __DMB();
+    *data = &ring->buf[start];
+    return (count < to_end) ? count : to_end;
+}
+
+uint16_t SPSC_Read(SPSC_Ring_t *ring, uint8_t *dst, uint16_t max_len)
+{
+    uint16_t count = SPSC_Count(ring);
+    uint16_t start = ring->tail & ring->mask;
+    uint16_t first;
+
+    if (count > max_len) {
+        count = max_len;
+    }
+    __DMB();
+    // 分两段拷贝处理回绕
+    first = ring->mask + 1 - start;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(dst, &ring->buf[start], first);
+    memcpy(dst + first, ring->buf, count - first);
+
+    SPSC_Consume(ring, count);
+    return count;
+}
+
+void SPSC_Consume(SPSC_Ring_t *ring, uint16_t n)
+{
+    uint16_t count = SPSC_Count(ring);
+
+    if (n > count) {
+        n = count;
+    }
+    __DMB(); // 数据读完后才释放空间给生产者
+    ring->tail = ring->tail + n;
+}
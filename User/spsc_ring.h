@@ -0,0 +1,61 @@
+#ifndef __SPSC_RING_H
+#define __SPSC_RING_H
+
+#include "stm32f10x.h"
+
+// ==========================================
+// 单生产者/单消费者无锁环形缓冲区 (串口接收通用)
+// ==========================================
+// - 生产者 (接收中断) 只写 head，消费者 (主循环) 只写 tail，双方无需关中断
+// - head/tail 为自由递增的 16 位计数，按 mask 取下标，容量 = size (必须是 2 的幂，最大 32768)
+// - 数据写入后、发布 head 之前加 __DMB，保证消费者看到 head 时数据已经写好；消费侧对称
+// - dropped/high_water 只由生产者写，主循环只读 (CMD:LINK_STATS)
+typedef struct {
+    uint8_t *buf;
+    uint16_t mask;              // size - 1
+    volatile uint16_t head;     // 生产者写入计数
+    volatile uint16_t tail;     // 消费者读取计数
+    volatile uint16_t high_water; // 最高占用字节数，用于按实测调整缓冲区大小
+    volatile uint32_t dropped;  // 缓冲区满丢弃的字节数
+} SPSC_Ring_t;
+
+void SPSC_Init(SPSC_Ring_t *ring, uint8_t *buf, uint16_t size);
+
+// 生产者 (中断中调用)：写入 1 字节，满时计入 dropped 并返回 0
+static __inline uint8_t SPSC_Put(SPSC_Ring_t *ring, uint8_t byte)
+{
+    uint16_t head = ring->head;
+    uint16_t used = (uint16_t)(head - ring->tail);
+
+    if (used > ring->mask) {
+        ring->dropped++;
+        return 0;
+    }
+    ring->buf[head & ring->mask] = byte;
+    __DMB();
+    ring->head = head + 1;
+    if (used >= ring->high_water) {
+        ring->high_water = used + 1;
+    }
+    return 1;
+}
+
+// 容量 (字节)
+#define SPSC_Size(ring)     ((uint16_t)((ring)->mask + 1))
+
+// 消费者：可读字节数
+static __inline uint16_t SPSC_Count(const SPSC_Ring_t *ring)
+{
+    return (uint16_t)(ring->head - ring->tail);
+}
+
+// 消费者：查看第 offset 个未读字节 (不消费)，调用方保证 offset < SPSC_Count()
+uint8_t SPSC_Peek(const SPSC_Ring_t *ring, uint16_t offset);
+// 消费者：返回从读位置开始的连续可读区域 (到缓冲区末尾为止)，配合 SPSC_Consume 原地处理
+uint16_t SPSC_Peek_Contig(const SPSC_Ring_t *ring, const uint8_t **data);
+// 消费者：批量拷贝出最多 max_len 字节并消费，返回实际字节数
+uint16_t SPSC_Read(SPSC_Ring_t *ring, uint8_t *dst, uint16_t max_len);
+// 消费者：丢弃 n 字节 (O(1))，n 超过可读字节数时清空
+void SPSC_Consume(SPSC_Ring_t *ring, uint16_t n);
+
+#endif
@@ -27,6 +27,7 @@
 #include "stm32f10x_it.h"
 #include "protocol.h" // ����Э��ͷ�ļ�
 #include "bsp_usart_dma.h"
+#include "scanner.h"
 
 /** @addtogroup STM32F10x_StdPeriph_Template
   * @{
@@ -161,6 +162,9 @@ void SysTick_Handler(void)
 // ����1�жϷ�����
 void USART1_IRQHandler(void)
 {
+    // 先读 SR 记录 ORE/FE/NE (随后读 DR 即清除)
+    Protocol_Receive_Error_IRQ(DEBUG_USARTx->SR);
+    
     // ����Ƿ��� RXNE (���ռĴ����ǿ�) �ж�
     if(USART_GetITStatus(DEBUG_USARTx, USART_IT_RXNE) != RESET)
     {
@@ -178,6 +182,23 @@ void USART1_IRQHandler(void)
     }
 }
 
+// DMA1 通道 4 (USART1_TX) 传输完成中断
+void DMA1_Channel4_IRQHandler(void)
+{
+    USART_TX_DMA_IRQ_Handler();
+}
+
+// 扫码枪串口 (UART4) 空闲中断 / DMA2 通道 3 半满、全满中断：推进接收写位置
+void SCANNER_USART_IRQHandler(void)
+{
+    Scanner_USART_IRQ_Handler();
+}
+
+void SCANNER_DMA_IRQHandler(void)
+{
+    Scanner_DMA_IRQ_Handler();
+}
+
 /**
   * @}
   */ 
@@ -0,0 +1,788 @@
+/*
+ * TJC 串口屏主机端模拟器
+ *
+ * 把固件的 User/screen/screen.c、tjc_usart_hmi.c (连同 spsc_ring.c、fmt.c) 原样编译到 Linux，
+ * USART2 / DMA1 通道 7 换成按波特率计时的模拟串口，另一端是一块模拟的 TJC 屏：
+ *   - 解析收到的指令 (以 0xff 0xff 0xff 结尾)，维护控件内容 (ln0~ln9、t1、t3、t4、pg)
+ *   - 按 bkcmd 回返回码，指令执行耗时、指令缓冲区溢出 (0x24)、随机丢指令可配置
+ *   - 注入启动帧和翻页按钮的触摸帧 (0x65)
+ * 按固定脚本 (连续扫码、重复扫码、翻页、清空) 驱动购物车，每一步统计发给屏幕的字节数、
+ * 指令数、占线时间和刷新完成延时，并检查屏幕显示与购物车是否一致。
+ *
+ * 用法 (在 tools/hmi_sim 下)：
+ *   make run                          # 默认参数运行
+ *   ./hmi_sim -b 9600 -n 40 -l 5 -v   # 9600 波特率、40 种商品、丢 5% 指令、打印指令流
+ *
+ * 退出码：0 = 每一步屏幕内容都与购物车一致，1 = 有不一致
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include "stm32f10x.h"
+#include "./screen/screen.h"
+#include "./screen/tjc_usart_hmi.h"
+#include "bsp_usart_dma.h"
+
+#define SIM_LOOP_US         50          // 主循环一圈的时间
+#define SIM_STEP_MS         1000        // 每一步运行的时间 (足够覆盖限帧间隔与应答超时重发)
+#define SIM_SCREEN_BUF      1024        // 屏幕串口指令缓冲区 (字节)，超出回 0x24 并丢弃
+#define SIM_CMD_MAX         256
+#define SIM_RX_QUEUE        4096
+#define SIM_CMD_QUEUE       64
+#define SIM_TEXT_MAX        128
+
+// ---------------- 外设替身 ----------------
+USART_TypeDef Sim_USART1, Sim_USART2;
+DMA_Channel_TypeDef Sim_DMA1_Channel7;
+GPIO_TypeDef Sim_GPIOA;
+SCB_Type Sim_SCB;
+
+static uint64_t simUs = 0;              // 模拟时间 (微秒)
+static uint32_t simPrimask = 0;
+static uint32_t simBaud = 0;            // 固件 uart2_init 设置的波特率
+static uint32_t simBaudOverride = 0;    // -b 指定时代替固件的设置
+static int simVerbose = 0;
+
+// 发送方向：DMA 一段传输结束时把整段数据交给屏幕
+static int dmaActive = 0;
+static uint64_t dmaDoneUs = 0;
+static uint8_t dmaData[2048];
+static uint16_t dmaLen = 0;
+static int dmaTC = 0;
+
+// 接收方向：屏幕发出的字节按波特率排队，到时间后进 USART2 接收中断
+typedef struct
+{
+    uint64_t at;
+    uint8_t byte;
+} Sim_Rx_Byte_t;
+static Sim_Rx_Byte_t rxQueue[SIM_RX_QUEUE];
+static unsigned rxHead = 0, rxTail = 0;
+static uint64_t rxLineFreeUs = 0;
+static int rxneFlag = 0;
+
+// ---------------- 模拟屏幕 ----------------
+typedef struct
+{
+    const char *name;
+    char text[SIM_TEXT_MAX];
+} Sim_Component_t;
+
+static Sim_Component_t screenObjs[] =
+{
+    {"t1"}, {"t3"}, {"t4"}, {"pg"},
+    {"ln0"}, {"ln1"}, {"ln2"}, {"ln3"}, {"ln4"}, {"ln5"}, {"ln6"}, {"ln7"}, {"ln8"}, {"ln9"},
+};
+#define SCREEN_OBJ_COUNT (sizeof(screenObjs) / sizeof(screenObjs[0]))
+
+typedef struct
+{
+    uint64_t at;                        // 执行完成时间
+    uint16_t len;
+    char cmd[SIM_CMD_MAX];
+} Sim_Cmd_t;
+static Sim_Cmd_t cmdQueue[SIM_CMD_QUEUE];
+static unsigned cmdHead = 0, cmdTail = 0;
+static uint32_t cmdQueuedBytes = 0;     // 屏幕缓冲区中尚未执行的字节
+static uint64_t screenFreeUs = 0;
+static char screenIn[SIM_CMD_MAX];
+static uint16_t screenInLen = 0;
+static int screenBkcmd = 2;             // TJC 上电默认：只返回失败
+static uint32_t screenProcUs = 300;     // 每条指令执行耗时
+static uint32_t screenLossPct = 0;      // 随机丢弃指令的百分比 (不执行、不应答)
+
+// 统计
+static uint64_t statBytes = 0;          // 发给屏幕的字节
+static uint32_t statCmds = 0;           // 屏幕执行的指令
+static uint64_t statLastExecUs = 0;     // 最后一条指令执行完成的时间
+
+static uint64_t Sim_Byte_Us(uint32_t n)
+{
+    uint32_t baud = simBaudOverride ? simBaudOverride : simBaud;
+
+    return (uint64_t)n * 10u * 1000000u / (baud ? baud : 115200);
+}
+
+static void Sim_Rx_Push(const uint8_t *data, uint16_t len, uint64_t at)
+{
+    uint64_t t = (at > rxLineFreeUs) ? at : rxLineFreeUs;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (rxHead - rxTail >= SIM_RX_QUEUE)
+        {
+            fprintf(stderr, "hmi_sim: rx queue overflow\n");
+            exit(2);
+        }
+        t += Sim_Byte_Us(1);
+        rxQueue[rxHead % SIM_RX_QUEUE].at = t;
+        rxQueue[rxHead % SIM_RX_QUEUE].byte = data[i];
+        rxHead++;
+    }
+    rxLineFreeUs = t;
+}
+
+static void Screen_Reply(uint8_t code, uint64_t at)
+{
+    uint8_t frame[4] = {code, 0xff, 0xff, 0xff};
+
+    Sim_Rx_Push(frame, sizeof(frame), at);
+}
+
+static Sim_Component_t *Screen_Find(const char *name, size_t len)
+{
+    for (size_t i = 0; i < SCREEN_OBJ_COUNT; i++)
+    {
+        if (strlen(screenObjs[i].name) == len && memcmp(screenObjs[i].name, name, len) == 0)
+        {
+            return &screenObjs[i];
+        }
+    }
+    return NULL;
+}
+
+// 执行一条指令，返回 TJC 返回码
+static uint8_t Screen_Exec(const char *cmd, uint16_t len)
+{
+    const char *eq;
+    Sim_Component_t *obj;
+
+    if (len > 6 && memcmp(cmd, "bkcmd=", 6) == 0)
+    {
+        screenBkcmd = atoi(cmd + 6);
+        return TJC_RET_SUCCESS;
+    }
+    if (len > 5 && memcmp(cmd, "page ", 5) == 0)
+    {
+        return TJC_RET_SUCCESS;
+    }
+    eq = strstr(cmd, ".txt=\"");
+    if (eq == NULL || cmd[len - 1] != '"' || len < (uint16_t)(eq - cmd) + 7)
+    {
+        return TJC_RET_INVALID_CMD;
+    }
+    obj = Screen_Find(cmd, (size_t)(eq - cmd));
+    if (obj == NULL)
+    {
+        return 0x1A;    // 无效变量名
+    }
+    len -= (uint16_t)(eq - cmd) + 7;
+    if (len >= SIM_TEXT_MAX)
+    {
+        len = SIM_TEXT_MAX - 1;
+    }
+    memcpy(obj->text, eq + 6, len);
+    obj->text[len] = '\0';
+    return TJC_RET_SUCCESS;
+}
+
+// 收到一段数据：按结束符切出指令放进屏幕指令缓冲区
+static void Screen_Feed(const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (screenInLen < SIM_CMD_MAX - 1)
+        {
+            screenIn[screenInLen++] = (char)data[i];
+        }
+        if (screenInLen < 3 || memcmp(&screenIn[screenInLen - 3], "\xff\xff\xff", 3) != 0)
+        {
+            continue;
+        }
+        screenInLen -= 3;
+        screenIn[screenInLen] = '\0';
+
+        if (screenLossPct != 0 && (uint32_t)(rand() % 100) < screenLossPct)
+        {
+            if (simVerbose) printf("  %9.3f ms  screen: LOST  %s\n", simUs / 1000.0, screenIn);
+        }
+        else if (cmdQueuedBytes + screenInLen + 3 > SIM_SCREEN_BUF || cmdHead - cmdTail >= SIM_CMD_QUEUE)
+        {
+            if (simVerbose) printf("  %9.3f ms  screen: OVERFLOW  %s\n", simUs / 1000.0, screenIn);
+            if (screenBkcmd >= 2) Screen_Reply(TJC_RET_BUFFER_OVERFLOW, simUs);
+        }
+        else
+        {
+            Sim_Cmd_t *c = &cmdQueue[cmdHead % SIM_CMD_QUEUE];
+
+            screenFreeUs = ((simUs > screenFreeUs) ? simUs : screenFreeUs) + screenProcUs;
+            c->at = screenFreeUs;
+            c->len = screenInLen;
+            memcpy(c->cmd, screenIn, screenInLen + 1);
+            cmdQueuedBytes += screenInLen + 3;
+            cmdHead++;
+        }
+        screenInLen = 0;
+    }
+}
+
+static void Screen_Run_Cmd(void)
+{
+    Sim_Cmd_t *c = &cmdQueue[cmdTail % SIM_CMD_QUEUE];
+    uint8_t ret = Screen_Exec(c->cmd, c->len);
+
+    cmdTail++;
+    cmdQueuedBytes -= c->len + 3;
+    statCmds++;
+    statLastExecUs = simUs;
+    if (simVerbose) printf("  %9.3f ms  screen: %-40s -> 0x%02X\n", simUs / 1000.0, c->cmd, ret);
+
+    if ((ret == TJC_RET_SUCCESS && (screenBkcmd == 1 || screenBkcmd == 3)) ||
+        (ret != TJC_RET_SUCCESS && screenBkcmd >= 2))
+    {
+        Screen_Reply(ret, simUs);
+    }
+}
+
+// 屏幕上电：控件清空、bkcmd 恢复默认，发启动帧
+static void Screen_Power_On(void)
+{
+    static const uint8_t startup[] = {0x00, 0x00, 0x00, 0xff, 0xff, 0xff};
+
+    for (size_t i = 0; i < SCREEN_OBJ_COUNT; i++)
+    {
+        screenObjs[i].text[0] = '\0';
+    }
+    screenBkcmd = 2;
+    cmdHead = cmdTail = 0;
+    cmdQueuedBytes = 0;
+    screenInLen = 0;
+    Sim_Rx_Push(startup, sizeof(startup), simUs);
+}
+
+static void Screen_Touch(uint8_t page, uint8_t id)
+{
+    uint8_t press[] = {TJC_FRAME_TOUCH, page, id, 0x01, 0xff, 0xff, 0xff};
+    uint8_t release[] = {TJC_FRAME_TOUCH, page, id, 0x00, 0xff, 0xff, 0xff};
+
+    // 接收线按顺序排队，松开紧跟按下发出 (提前排一个未来的时间会把之后的应答都堵在后面)
+    Sim_Rx_Push(press, sizeof(press), simUs);
+    Sim_Rx_Push(release, sizeof(release), simUs);
+}
+
+// ---------------- 事件推进 ----------------
+static void Sim_Fire_DMA(void)
+{
+    simUs = dmaDoneUs;
+    dmaActive = 0;
+    Screen_Feed(dmaData, dmaLen);
+    dmaTC = 1;
+    Sim_SCB.ICSR = 16 + DMA1_Channel7_IRQn;
+    DMA1_Channel7_IRQHandler();
+    Sim_SCB.ICSR = 0;
+}
+
+static void Sim_Fire_Rx(void)
+{
+    Sim_Rx_Byte_t *b = &rxQueue[rxTail % SIM_RX_QUEUE];
+
+    simUs = b->at;
+    rxTail++;
+    Sim_USART2.DR = b->byte;
+    rxneFlag = 1;
+    Sim_SCB.ICSR = 16 + USART2_IRQn;
+    USART2_IRQHandler();
+    Sim_SCB.ICSR = 0;
+}
+
+// 下一个事件的时间，没有事件返回 UINT64_MAX
+static uint64_t Sim_Next_Event(int *kind)
+{
+    uint64_t t = UINT64_MAX;
+
+    *kind = 0;
+    if (dmaActive && dmaDoneUs < t)
+    {
+        t = dmaDoneUs;
+        *kind = 1;
+    }
+    if (rxTail != rxHead && rxQueue[rxTail % SIM_RX_QUEUE].at < t)
+    {
+        t = rxQueue[rxTail % SIM_RX_QUEUE].at;
+        *kind = 2;
+    }
+    if (cmdTail != cmdHead && cmdQueue[cmdTail % SIM_CMD_QUEUE].at < t)
+    {
+        t = cmdQueue[cmdTail % SIM_CMD_QUEUE].at;
+        *kind = 3;
+    }
+    return t;
+}
+
+static void Sim_Run_Event(int kind, uint64_t t)
+{
+    switch (kind)
+    {
+    case 1:
+        Sim_Fire_DMA();
+        break;
+    case 2:
+        Sim_Fire_Rx();
+        break;
+    case 3:
+        simUs = t;
+        Screen_Run_Cmd();
+        break;
+    }
+}
+
+// 处理 until 之前的所有事件 (中断只在开中断时发生)
+static void Sim_Advance(uint64_t until)
+{
+    int kind;
+    uint64_t t;
+
+    while (simPrimask == 0 && (t = Sim_Next_Event(&kind)) <= until)
+    {
+        Sim_Run_Event(kind, t);
+    }
+    if (until > simUs)
+    {
+        simUs = until;
+    }
+}
+
+uint32_t Sim_Busy_Wait(void)
+{
+    int kind;
+    uint64_t t;
+
+    if (Sim_SCB.ICSR == 0 && simPrimask == 0)
+    {
+        t = Sim_Next_Event(&kind);
+        if (t == UINT64_MAX)
+        {
+            fprintf(stderr, "hmi_sim: firmware is spinning with nothing in flight\n");
+            exit(2);
+        }
+        Sim_Run_Event(kind, t);
+    }
+    return 0x1FF;
+}
+
+// ---------------- core_cm3 / 标准库替身 ----------------
+uint32_t __get_PRIMASK(void) { return simPrimask; }
+void __set_PRIMASK(uint32_t primask) { simPrimask = primask; }
+void __disable_irq(void) { simPrimask = 1; }
+void __enable_irq(void) { simPrimask = 0; }
+
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state) { (void)periph; (void)state; }
+void GPIO_StructInit(GPIO_InitTypeDef *init) { memset(init, 0, sizeof(*init)); }
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init) { (void)gpio; (void)init; }
+void NVIC_Init(NVIC_InitTypeDef *init) { (void)init; }
+
+void USART_DeInit(USART_TypeDef *usart) { memset(usart, 0, sizeof(*usart)); }
+void USART_StructInit(USART_InitTypeDef *init) { memset(init, 0, sizeof(*init)); init->USART_BaudRate = 9600; }
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init)
+{
+    if (usart == USART2)
+    {
+        simBaud = init->USART_BaudRate;
+    }
+}
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state) { (void)usart; (void)state; }
+void USART_ITConfig(USART_TypeDef *usart, uint16_t it, FunctionalState state) { (void)usart; (void)it; (void)state; }
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state) { (void)usart; (void)req; (void)state; }
+void USART_ClearFlag(USART_TypeDef *usart, uint16_t flag) { (void)usart; (void)flag; }
+FlagStatus USART_GetFlagStatus(USART_TypeDef *usart, uint16_t flag)
+{
+    (void)usart;
+    return (flag == USART_FLAG_TC && !dmaActive) ? SET : RESET;
+}
+ITStatus USART_GetITStatus(USART_TypeDef *usart, uint16_t it)
+{
+    return (usart == USART2 && it == USART_IT_RXNE && rxneFlag) ? SET : RESET;
+}
+void USART_ClearITPendingBit(USART_TypeDef *usart, uint16_t it) { (void)usart; (void)it; rxneFlag = 0; }
+uint16_t USART_ReceiveData(USART_TypeDef *usart) { rxneFlag = 0; return usart->DR; }
+void USART_SendData(USART_TypeDef *usart, uint16_t data) { usart->DR = data; }
+void USART_Rx_Count_Errors(uint16_t sr, USART_Rx_Errors_t *err) { (void)sr; (void)err; }
+
+void DMA_DeInit(DMA_Channel_TypeDef *ch) { memset(ch, 0, sizeof(*ch)); }
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init)
+{
+    ch->CPAR = init->DMA_PeripheralBaseAddr;
+    ch->CMAR = init->DMA_MemoryBaseAddr;
+    ch->CNDTR = init->DMA_BufferSize;
+}
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state) { (void)ch; (void)it; (void)state; }
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *ch, uint16_t count) { ch->CNDTR = count; }
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch) { return (uint16_t)ch->CNDTR; }
+ITStatus DMA_GetITStatus(uint32_t it) { return (it == DMA1_IT_TC7 && dmaTC) ? SET : RESET; }
+void DMA_ClearITPendingBit(uint32_t it) { if (it == DMA1_IT_TC7) dmaTC = 0; }
+
+// 启动一段发送：数据按波特率占线，结束时产生传输完成中断
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state)
+{
+    uint64_t start;
+
+    if (ch != DMA1_Channel7 || state != ENABLE)
+    {
+        return;
+    }
+    // CMAR 只有 32 位，模拟器用 -no-pie 编译保证静态数据在低 4GB
+    dmaLen = (uint16_t)ch->CNDTR;
+    memcpy(dmaData, (const void *)(uintptr_t)ch->CMAR, dmaLen);
+    start = (simUs > dmaDoneUs) ? simUs : dmaDoneUs;
+    dmaDoneUs = start + Sim_Byte_Us(dmaLen);
+    dmaActive = 1;
+    statBytes += dmaLen;
+}
+
+int Log_Printf(uint8_t level, const char *fmt, ...)
+{
+    va_list ap;
+    int n = 0;
+
+    (void)level;
+    if (simVerbose)
+    {
+        printf("  %9.3f ms  fw: ", simUs / 1000.0);
+        va_start(ap, fmt);
+        n = vprintf(fmt, ap);
+        va_end(ap);
+        if (n > 0 && fmt[strlen(fmt) - 1] != '\n') printf("\n");
+    }
+    return n;
+}
+
+// ---------------- 商品库 (代替 products.c 的 Flash 查询) ----------------
+#define SIM_ID_BASE 6900000000000ULL
+static uint32_t statNameBatches = 0;    // Product_Find_Batch 调用次数 (真机上每次遍历一遍 Flash)
+
+static uint32_t Sim_Price(int n) { return 150u + (uint32_t)n * 37u; }
+
+uint8_t Product_Find_Batch(const uint64_t *sorted_ids, uint8_t count, Product_Item_t *out_items, uint8_t *found)
+{
+    statNameBatches++;
+    for (uint8_t k = 0; k < count; k++)
+    {
+        int n = (int)(sorted_ids[k] - SIM_ID_BASE);
+
+        memset(&out_items[k], 0, sizeof(out_items[k]));
+        out_items[k].id = sorted_ids[k];
+        out_items[k].price = Sim_Price(n);
+        snprintf(out_items[k].name, sizeof(out_items[k].name), "Item%02d", n);
+        found[k] = 1;
+    }
+    return count;
+}
+
+// ---------------- 购物车 (与 main.h 中 add_product_to_shopping_car / clear_shopping_car 相同) ----------------
+static void Sim_Scan(int n, int count)
+{
+    char itemName[CART_NAME_LENGTH];
+    uint8_t is_new;
+    int i = Cart_Add(SIM_ID_BASE + (uint64_t)n, Sim_Price(n), (uint16_t)count, &is_new);
+
+    if (i < 0)
+    {
+        return;
+    }
+    if (is_new)
+    {
+        snprintf(itemName, sizeof(itemName), "Item%02d", n);
+        Screen_Cache_Line_Name(i, itemName);
+        Screen_Show_Line(i);
+    }
+    Screen_Mark_Line_Dirty(i);
+}
+
+static void Sim_Clear(void)
+{
+    Cart_Clear();
+    Screen_Mark_All_Dirty();
+}
+
+// 与 main.h 中 set_shopping_car_count 相同
+static void Sim_Set_Count(int index, uint16_t count)
+{
+    if (count == 0)
+    {
+        Cart_Remove(index);
+        Screen_Line_Removed(index);
+        return;
+    }
+    Cart_Set_Count(index, count);
+    Screen_Mark_Line_Dirty(index);
+}
+
+// 与 main.c 中 Screen_Cart_Op_Poll 相同 (不回复上位机)
+static void Sim_Cart_Op_Poll(void)
+{
+    int index;
+    Screen_Cart_Op_t op = Screen_Get_Cart_Op(&index);
+    uint16_t count;
+
+    if (op == SCREEN_CART_OP_NONE)
+    {
+        return;
+    }
+    count = Cart_Get_Line(index)->count;
+    if (op == SCREEN_CART_OP_DEC)
+    {
+        count--;
+    }
+    else if (op == SCREEN_CART_OP_INC)
+    {
+        count++;
+    }
+    else
+    {
+        count = 0;
+    }
+    Sim_Set_Count(index, count);
+}
+
+// ---------------- 校验与统计 ----------------
+static int stepMismatch = 0;
+
+static const char *Screen_Text(const char *name)
+{
+    return Screen_Find(name, strlen(name))->text;
+}
+
+// 屏幕内容与购物车对照：当前页的 10 行、总价、页码
+static int Check_Screen(void)
+{
+    char expect[SIM_TEXT_MAX];
+    char name[8];
+    uint32_t total = Cart_Total();
+    int page = 0, pages = 0, first, errors = 0;
+
+    if (sscanf(Screen_Text("pg"), "%d/%d", &page, &pages) != 2 || page < 1)
+    {
+        printf("    mismatch: pg=\"%s\"\n", Screen_Text("pg"));
+        return 1;
+    }
+    first = (page - 1) * SCREEN_CART_LINES;
+    for (int r = 0; r < SCREEN_CART_LINES; r++)
+    {
+        int i = first + r;
+
+        expect[0] = '\0';
+        if (i < Cart_Count())
+        {
+            const Cart_Line_t *line = Cart_Get_Line(i);
+
+            char itemName[CART_NAME_LENGTH];
+
+            snprintf(itemName, sizeof(itemName), "Item%02d", (int)(line->id - SIM_ID_BASE));
+            snprintf(expect, sizeof(expect), "%7s,%04u.%02u,%07d", itemName,
+                     line->price / 100, line->price % 100, line->count);
+        }
+        snprintf(name, sizeof(name), SCREEN_LINE_OBJ "%d", r);
+        if (strcmp(expect, Screen_Text(name)) != 0)
+        {
+            printf("    mismatch: %s=\"%s\" expected \"%s\"\n", name, Screen_Text(name), expect);
+            errors++;
+        }
+    }
+    snprintf(expect, sizeof(expect), "%u.%02u", total / 100, total % 100);
+    if (strcmp(expect, Screen_Text("t3")) != 0)
+    {
+        printf("    mismatch: t3=\"%s\" expected \"%s\"\n", Screen_Text("t3"), expect);
+        errors++;
+    }
+    if (pages != (Cart_Count() + SCREEN_CART_LINES - 1) / SCREEN_CART_LINES && !(Cart_Count() == 0 && pages == 1))
+    {
+        printf("    mismatch: pg=\"%s\" for %d items\n", Screen_Text("pg"), Cart_Count());
+        errors++;
+    }
+    return errors;
+}
+
+// 模拟主循环：TJC_Poll_Frames + Screen_Render_Task，与 main.c 相同
+static void Run_Main_Loop(uint64_t duration_us)
+{
+    uint64_t end = simUs + duration_us;
+
+    while (simUs < end)
+    {
+        uint32_t now_ms = (uint32_t)(simUs / 1000);
+
+        TJC_Poll_Frames(now_ms);
+        Sim_Cart_Op_Poll();
+        Screen_Render_Task(now_ms);
+        Sim_Advance(simUs + SIM_LOOP_US);
+    }
+}
+
+static void Run_Step(const char *name)
+{
+    static uint64_t bytes0, cmds0, t0;
+    uint64_t bytes, cmds;
+    int errors;
+
+    bytes0 = statBytes;
+    cmds0 = statCmds;
+    t0 = simUs;
+    statLastExecUs = t0;
+    if (simVerbose) printf("-- %s\n", name);
+
+    Run_Main_Loop((uint64_t)SIM_STEP_MS * 1000);
+
+    bytes = statBytes - bytes0;
+    cmds = statCmds - cmds0;
+    errors = Check_Screen();
+    stepMismatch += errors;
+    printf("%-26s %7llu %5llu %9.2f %11.2f  %s\n", name, (unsigned long long)bytes, (unsigned long long)cmds,
+           Sim_Byte_Us((uint32_t)bytes) / 1000.0, (statLastExecUs - t0) / 1000.0, errors ? "MISMATCH" : "ok");
+}
+
+static void Usage(void)
+{
+    fprintf(stderr,
+            "usage: hmi_sim [-b baud] [-n items] [-p proc_us] [-l loss_pct] [-s seed] [-v]\n"
+            "  -b  screen line baud rate (default: firmware uart2_init)\n"
+            "  -n  distinct products to scan (1..%d, default 25)\n"
+            "  -p  screen execution time per command in us (default 300)\n"
+            "  -l  percent of commands the screen silently drops (default 0)\n"
+            "  -s  random seed for -l (default 1)\n"
+            "  -v  print the command stream and firmware log\n", CART_MAX_LINES);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int items = 25;
+    unsigned seed = 1;
+    int opt;
+    char name[48];
+    TJC_Ack_Stats_t ack;
+
+    while ((opt = getopt(argc, argv, "b:n:p:l:s:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': simBaudOverride = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'n': items = atoi(optarg); break;
+        case 'p': screenProcUs = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'l': screenLossPct = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'v': simVerbose = 1; break;
+        default: Usage();
+        }
+    }
+    if (items < 1 || items > CART_MAX_LINES)
+    {
+        Usage();
+    }
+    if ((uintptr_t)&Sim_DMA1_Channel7 > 0xFFFFFFFFu)
+    {
+        fprintf(stderr, "hmi_sim: static data above 4GB, build with -no-pie\n");
+        return 2;
+    }
+    srand(seed);
+
+    Screen_Shopping_System_Init();
+    printf("baud %u, screen %u us/cmd, loss %u%%, window %d lines, ack window %d\n\n",
+           simBaudOverride ? simBaudOverride : simBaud, screenProcUs, screenLossPct,
+           SCREEN_CART_LINES, TJC_ACK_WINDOW);
+    printf("%-26s %7s %5s %9s %11s\n", "step", "bytes", "cmds", "line_ms", "latency_ms");
+
+    Screen_Power_On();
+    Run_Step("power on");
+
+    for (int n = 1; n <= items; n++)
+    {
+        Sim_Scan(n, 1);
+        snprintf(name, sizeof(name), "scan new #%d", n);
+        Run_Step(name);
+    }
+    Sim_Scan(items, 2);
+    Run_Step("rescan visible item");
+    {
+        // 旧版单字节事件 (printh 01) 后面紧跟触摸帧，中间没有静默：两者都要识别出来
+        static const uint8_t legacy[] = {0x01};
+        uint32_t frameErrors = TJC_Get_Frame_Errors();
+        int page = 0;
+
+        Sim_Rx_Push(legacy, sizeof(legacy), simUs);
+        Screen_Touch(1, SCREEN_BTN_LINE_FIRST);
+        Run_Step("legacy byte + touch");
+        sscanf(Screen_Text("pg"), "%d", &page);
+        snprintf(name, sizeof(name), "line %d selected", (page - 1) * SCREEN_CART_LINES + 1);
+        if (!Screen_Check_Start_Shopping_Msg() || strcmp(Screen_Text("t4"), name) != 0 ||
+            TJC_Get_Frame_Errors() != frameErrors)
+        {
+            printf("  !! legacy byte or following touch frame lost (t4=\"%s\")\n", Screen_Text("t4"));
+            stepMismatch++;
+        }
+    }
+    if (items > SCREEN_CART_LINES)
+    {
+        Sim_Scan(1, 1);
+        Run_Step("rescan item off-page");
+        Screen_Touch(1, SCREEN_BTN_PAGE_UP);
+        Run_Step("touch page up");
+        Screen_Touch(1, SCREEN_BTN_PAGE_DOWN);
+        Run_Step("touch page down");
+    }
+    if (items > SCREEN_TEXT_CACHE)
+    {
+        // 翻回两页以前：名称已被挤出缓存，需要从 Flash 批量取回
+        Screen_Touch(1, SCREEN_BTN_PAGE_UP);
+        Screen_Touch(1, SCREEN_BTN_PAGE_UP);
+        Run_Step("touch page up x2");
+    }
+    for (int n = 0; n < 5; n++)
+    {
+        Sim_Scan(items, 1);
+    }
+    Run_Step("5 rapid rescans (1 frame)");
+    Sim_Set_Count(Cart_Count() - 1, 3);
+    Run_Step("set qty of last line");
+    Sim_Set_Count(Cart_Count() - 1, 0);
+    Run_Step("remove last line");
+    if (Cart_Count() > 1)
+    {
+        // 删除中间一行：后面的行前移一位，扫码顺序不变
+        uint64_t before[CART_MAX_LINES];
+        int removed = Cart_Count() / 2;
+        int kept = Cart_Count() - 1;
+
+        for (int i = 0; i < Cart_Count(); i++)
+        {
+            before[i] = Cart_Get_Line(i)->id;
+        }
+        Sim_Set_Count(removed, 0);
+        Run_Step("remove middle line");
+        for (int i = 0; i < kept; i++)
+        {
+            if (Cart_Get_Line(i)->id != before[i < removed ? i : i + 1])
+            {
+                printf("  !! line %d out of scan order after removal\n", i);
+                stepMismatch++;
+                break;
+            }
+        }
+        // 触摸选中当前页第一行：加一、减一、删除
+        Screen_Touch(1, SCREEN_BTN_LINE_FIRST);
+        Screen_Touch(1, SCREEN_BTN_INC);
+        Run_Step("touch select + inc");
+        Screen_Touch(1, SCREEN_BTN_DEC);
+        Run_Step("touch dec");
+        Screen_Touch(1, SCREEN_BTN_VOID);
+        Run_Step("touch void line");
+    }
+    Screen_Power_On();
+    Run_Step("screen reboot");
+    Sim_Clear();
+    Run_Step("clear cart");
+
+    TJC_Get_Ack_Stats(&ack);
+    printf("\nsent %llu bytes, %u commands in %.1f ms; acks ok %u, err %u, lost %u; "
+           "last-second rate %u cmd/s; flash name lookups %u\n",
+           (unsigned long long)statBytes, statCmds, simUs / 1000.0,
+           ack.ok, ack.err, ack.lost, ack.rate, statNameBatches);
+    printf("%s\n", stepMismatch ? "FAIL: screen content diverged from the cart" : "PASS");
+    return stepMismatch ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+#ifndef __STM32F10x_H
+#define __STM32F10x_H
+
+// ==========================================
+// 主机端替身：只提供 screen.c / tjc_usart_hmi.c 用到的寄存器、类型和标准库函数
+// ==========================================
+// 外设寄存器是普通内存，库函数由 hmi_sim.c 实现：USART2 波特率、DMA1 通道 7 的传输、
+// 接收中断都交给模拟器按波特率计时。固件源码不做任何修改。
+
+#include <stdint.h>
+
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+
+typedef struct
+{
+    volatile uint16_t SR;
+    volatile uint16_t DR;
+    volatile uint16_t BRR;
+    volatile uint16_t CR1;
+    volatile uint16_t CR2;
+    volatile uint16_t CR3;
+    volatile uint16_t GTPR;
+} USART_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CCR;
+    volatile uint32_t CNDTR;
+    volatile uint32_t CPAR;
+    volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CRL;
+    volatile uint32_t CRH;
+    volatile uint32_t IDR;
+    volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+extern USART_TypeDef Sim_USART1, Sim_USART2;
+extern DMA_Channel_TypeDef Sim_DMA1_Channel7;
+extern GPIO_TypeDef Sim_GPIOA;
+extern SCB_Type Sim_SCB;
+
+#define USART1              (&Sim_USART1)
+#define USART2              (&Sim_USART2)
+#define USART1_BASE         0
+#define DMA1_Channel7       (&Sim_DMA1_Channel7)
+#define GPIOA               (&Sim_GPIOA)
+#define SCB                 (&Sim_SCB)
+
+// 发送缓冲区满时固件在主循环里自旋等待，并在自旋中读取此掩码判断是否处于中断；
+// 模拟器借这次读取推进时间，让 DMA 把数据发出去，否则自旋永远不会结束
+uint32_t Sim_Busy_Wait(void);
+#define SCB_ICSR_VECTACTIVE_Msk (Sim_Busy_Wait())
+
+typedef enum
+{
+    USART1_IRQn = 37,
+    USART2_IRQn = 38,
+    DMA1_Channel7_IRQn = 17,
+} IRQn_Type;
+
+// ---------------- core_cm3 ----------------
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+#define __DMB()     __sync_synchronize()
+
+// ---------------- RCC ----------------
+#define RCC_APB2Periph_AFIO     0x0001
+#define RCC_APB2Periph_GPIOA    0x0004
+#define RCC_APB2Periph_USART1   0x4000
+#define RCC_APB1Periph_USART2   0x00020000
+#define RCC_AHBPeriph_DMA1      0x0001
+void RCC_APB2PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_APB1PeriphClockCmd(uint32_t periph, FunctionalState state);
+void RCC_AHBPeriphClockCmd(uint32_t periph, FunctionalState state);
+
+// ---------------- GPIO ----------------
+typedef enum {GPIO_Speed_10MHz = 1, GPIO_Speed_2MHz, GPIO_Speed_50MHz} GPIOSpeed_TypeDef;
+typedef enum {GPIO_Mode_IN_FLOATING = 0x04, GPIO_Mode_AF_PP = 0x18} GPIOMode_TypeDef;
+typedef struct
+{
+    uint16_t GPIO_Pin;
+    GPIOSpeed_TypeDef GPIO_Speed;
+    GPIOMode_TypeDef GPIO_Mode;
+} GPIO_InitTypeDef;
+#define GPIO_Pin_2      0x0004
+#define GPIO_Pin_3      0x0008
+#define GPIO_Pin_9      0x0200
+#define GPIO_Pin_10     0x0400
+void GPIO_StructInit(GPIO_InitTypeDef *init);
+void GPIO_Init(GPIO_TypeDef *gpio, GPIO_InitTypeDef *init);
+
+// ---------------- USART ----------------
+typedef struct
+{
+    uint32_t USART_BaudRate;
+    uint16_t USART_WordLength;
+    uint16_t USART_StopBits;
+    uint16_t USART_Parity;
+    uint16_t USART_Mode;
+    uint16_t USART_HardwareFlowControl;
+} USART_InitTypeDef;
+#define USART_WordLength_8b                 0x0000
+#define USART_StopBits_1                    0x0000
+#define USART_Parity_No                     0x0000
+#define USART_Mode_Rx                       0x0004
+#define USART_Mode_Tx                       0x0008
+#define USART_HardwareFlowControl_None      0x0000
+#define USART_FLAG_NE                       0x0004
+#define USART_FLAG_FE                       0x0002
+#define USART_FLAG_ORE                      0x0008
+#define USART_FLAG_IDLE                     0x0010
+#define USART_FLAG_RXNE                     0x0020
+#define USART_FLAG_TC                       0x0040
+#define USART_IT_RXNE                       0x0525
+#define USART_IT_IDLE                       0x0424
+#define USART_DMAReq_Tx                     0x0080
+void USART_DeInit(USART_TypeDef *usart);
+void USART_StructInit(USART_InitTypeDef *init);
+void USART_Init(USART_TypeDef *usart, USART_InitTypeDef *init);
+void USART_Cmd(USART_TypeDef *usart, FunctionalState state);
+void USART_ITConfig(USART_TypeDef *usart, uint16_t it, FunctionalState state);
+void USART_DMACmd(USART_TypeDef *usart, uint16_t req, FunctionalState state);
+void USART_ClearFlag(USART_TypeDef *usart, uint16_t flag);
+FlagStatus USART_GetFlagStatus(USART_TypeDef *usart, uint16_t flag);
+ITStatus USART_GetITStatus(USART_TypeDef *usart, uint16_t it);
+void USART_ClearITPendingBit(USART_TypeDef *usart, uint16_t it);
+uint16_t USART_ReceiveData(USART_TypeDef *usart);
+void USART_SendData(USART_TypeDef *usart, uint16_t data);
+
+// ---------------- DMA ----------------
+typedef struct
+{
+    uint32_t DMA_PeripheralBaseAddr;
+    uint32_t DMA_MemoryBaseAddr;
+    uint32_t DMA_DIR;
+    uint32_t DMA_BufferSize;
+    uint32_t DMA_PeripheralInc;
+    uint32_t DMA_MemoryInc;
+    uint32_t DMA_PeripheralDataSize;
+    uint32_t DMA_MemoryDataSize;
+    uint32_t DMA_Mode;
+    uint32_t DMA_Priority;
+    uint32_t DMA_M2M;
+} DMA_InitTypeDef;
+#define DMA_DIR_PeripheralDST               0x0010
+#define DMA_PeripheralInc_Disable           0x0000
+#define DMA_MemoryInc_Enable                0x0080
+#define DMA_PeripheralDataSize_Byte         0x0000
+#define DMA_MemoryDataSize_Byte             0x0000
+#define DMA_Mode_Normal                     0x0000
+#define DMA_Priority_Low                    0x0000
+#define DMA_M2M_Disable                     0x0000
+#define DMA_IT_TC                           0x0002
+#define DMA1_IT_TC7                         0x02000000
+void DMA_DeInit(DMA_Channel_TypeDef *ch);
+void DMA_Init(DMA_Channel_TypeDef *ch, DMA_InitTypeDef *init);
+void DMA_ITConfig(DMA_Channel_TypeDef *ch, uint32_t it, FunctionalState state);
+void DMA_Cmd(DMA_Channel_TypeDef *ch, FunctionalState state);
+void DMA_SetCurrDataCounter(DMA_Channel_TypeDef *ch, uint16_t count);
+uint16_t DMA_GetCurrDataCounter(DMA_Channel_TypeDef *ch);
+ITStatus DMA_GetITStatus(uint32_t it);
+void DMA_ClearITPendingBit(uint32_t it);
+
+// ---------------- NVIC ----------------
+typedef struct
+{
+    uint8_t NVIC_IRQChannel;
+    uint8_t NVIC_IRQChannelPreemptionPriority;
+    uint8_t NVIC_IRQChannelSubPriority;
+    FunctionalState NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+void NVIC_Init(NVIC_InitTypeDef *init);
+
+#endif
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+USART1 日志解码工具
+
+固件的二进制日志 (LOG_BIN) 只发送 ID 和 32 位参数，格式串保存在 User/log_ids.h。
+本工具从 log_ids.h 生成字符串表，把串口数据中的二进制帧还原成文本，
+协议应答 (CMD:...) 和文本日志原样输出。
+
+帧格式: 0x1E | ID(2B LE) | 参数个数(1B) | 参数(每个 4B LE)... | '\\n'
+        帧内 0x0A/0x1E/0x1B 转义为 0x1B, (字节 ^ 0x20)
+
+用法:
+  python tools/log_decode.py --port COM3 --baud 115200      # 实时解码 (需要 pyserial)
+  python tools/log_decode.py capture.bin                    # 解码抓包文件
+  python tools/log_decode.py --dump-table                   # 打印生成的字符串表
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+LOG_BIN_START = 0x1E
+LOG_BIN_ESC = 0x1B
+
+DEFAULT_TABLE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "User", "log_ids.h")
+
+LOG_DEF_RE = re.compile(r'LOG_DEF\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_RE = re.compile(r'%(\{[^}]*\}|%|[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l)?[diuxXfcs])')
+
+
+def load_table(path):
+    """按出现顺序解析 LOG_DEF，序号即 ID"""
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    table = []
+    for name, level, fmt in LOG_DEF_RE.findall(text):
+        fmt = bytes(fmt, "utf-8").decode("unicode_escape").encode("latin-1").decode("utf-8")
+        table.append((name, level, fmt))
+    return table
+
+
+def format_message(fmt, args):
+    """按格式串把 32 位参数还原成文本"""
+    out = []
+    pos = 0
+    arg_idx = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        spec = m.group(1)
+        if spec == "%":
+            out.append("%")
+            continue
+        if arg_idx >= len(args):
+            out.append("<missing>")
+            continue
+        raw = args[arg_idx]
+        arg_idx += 1
+
+        if spec.startswith("{"):
+            names = spec[1:-1].split("|")
+            out.append(names[raw] if raw < len(names) else str(raw))
+            continue
+
+        conv = spec[-1]
+        flags = re.sub(r"(hh|h|ll|l)(?=[diuxXfcs]$)", "", spec)
+        if conv == "f":
+            value = struct.unpack("<f", struct.pack("<I", raw))[0]
+        elif conv == "d" or conv == "i":
+            value = raw - (1 << 32) if raw & 0x80000000 else raw
+            flags = flags[:-1] + "d"
+        elif conv == "u":
+            value = raw
+            flags = flags[:-1] + "d"
+        elif conv == "c":
+            value = raw & 0xFF
+        elif conv == "s":
+            value = str(raw)
+        else:
+            value = raw
+        out.append(("%" + flags) % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode_frame(payload, table):
+    """payload: 已去掉起始字节与换行、未反转义的帧内容"""
+    raw = bytearray()
+    esc = False
+    for b in payload:
+        if esc:
+            raw.append(b ^ 0x20)
+            esc = False
+        elif b == LOG_BIN_ESC:
+            esc = True
+        else:
+            raw.append(b)
+
+    if len(raw) < 3:
+        return "<bad frame: %s>" % payload.hex()
+    log_id = raw[0] | (raw[1] << 8)
+    argc = raw[2]
+    if len(raw) != 3 + 4 * argc:
+        return "<bad frame id=%d: %s>" % (log_id, raw.hex())
+    args = list(struct.unpack("<%dI" % argc, bytes(raw[3:])))
+    if log_id >= len(table):
+        return "<unknown id=%d args=%s>" % (log_id, args)
+    return format_message(table[log_id][2], args)
+
+
+class StreamDecoder:
+    """按 '\\n' 切行：0x1E 开头的是二进制帧，其余按文本输出"""
+
+    def __init__(self, table):
+        self.table = table
+        self.buf = bytearray()
+
+    def feed(self, data):
+        lines = []
+        self.buf.extend(data)
+        while True:
+            idx = self.buf.find(b"\n")
+            if idx < 0:
+                break
+            line = bytes(self.buf[:idx])
+            del self.buf[:idx + 1]
+            lines.append(self.decode_line(line))
+        return lines
+
+    def decode_line(self, line):
+        # LOG_E/W/I/D 和 LOG_BIN 都整条写入，帧前面只会是直接 printf 且没有换行的文本
+        start = line.find(bytes([LOG_BIN_START]))
+        if start < 0:
+            return line.rstrip(b"\r").decode("utf-8", errors="replace")
+        prefix = line[:start].rstrip(b"\r").decode("utf-8", errors="replace")
+        return prefix + decode_frame(line[start + 1:], self.table)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode STM32 USART1 binary log frames")
+    parser.add_argument("file", nargs="?", help="抓包文件 (省略且未指定 --port 时读 stdin)")
+    parser.add_argument("--table", default=DEFAULT_TABLE, help="log_ids.h 路径")
+    parser.add_argument("--port", help="串口号，例如 COM3 或 /dev/ttyUSB0")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--dump-table", action="store_true", help="打印 ID 与格式串后退出")
+    args = parser.parse_args()
+
+    table = load_table(args.table)
+    if args.dump_table:
+        for i, (name, level, fmt) in enumerate(table):
+            print("%3d  %-22s %-16s %s" % (i, name, level, fmt))
+        return
+
+    decoder = StreamDecoder(table)
+    if args.port:
+        import serial  # pyserial
+        with serial.Serial(args.port, args.baud, timeout=0.1) as ser:
+            while True:
+                for line in decoder.feed(ser.read(256)):
+                    print(line, flush=True)
+    else:
+        src = open(args.file, "rb") if args.file else sys.stdin.buffer
+        with src:
+            while True:
+                chunk = src.read(4096)
+                if not chunk:
+                    break
+                for line in decoder.feed(chunk):
+                    print(line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,264 @@
+/*
+ * SPSC 环形缓冲区多线程压力测试
+ *
+ * 把固件的 User/spsc_ring.c 原样编译到 Linux (设备头文件用 tools/hmi_sim/stub/stm32f10x.h，
+ * __DMB 即全屏障)，一个线程当接收中断只调 SPSC_Put，另一个线程当主循环，轮流用
+ * SPSC_Peek_Contig + SPSC_Consume、SPSC_Read、SPSC_Peek + SPSC_Consume 三种方式读取：
+ *   - 生产者按伪随机序列写入，只有 SPSC_Put 成功才前进，消费者按同一序列逐字节核对
+ *     (丢字节、重复、乱序都会立刻对不上)
+ *   - head/tail 从 0xFFF0 开始，运行中 16 位计数回绕几百次
+ *   - 消费者随机停顿让缓冲区写满：dropped 必须等于生产者看到的失败次数，
+ *     high_water 不超过容量、只增不减，写满过则必须等于容量
+ *
+ * 用法 (在 tools/spsc_stress 下)：
+ *   make run                     # 默认参数运行
+ *   ./spsc_stress -z 16 -n 50    # 16 字节缓冲区、写入 5000 万字节
+ *
+ * 退出码：0 = 全部核对通过，1 = 有错误
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "spsc_ring.h"
+
+#define STRESS_SIZE_MAX     32768
+
+static uint8_t stressBuf[STRESS_SIZE_MAX];
+static SPSC_Ring_t ring;
+static uint16_t ringSize = 64;
+static uint64_t totalBytes = 20000000;     // 生产者成功写入的字节数
+static uint32_t seed = 1;
+
+static uint64_t producerFails = 0;         // 生产者看到的 SPSC_Put 失败次数
+static volatile int producerDone = 0;
+static int errors = 0;
+
+// 数据序列：两端各自推进，第 k 个成功写入的字节 = 第 k 次 Seq_Next 的低 8 位
+static uint8_t Seq_Next(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (uint8_t)(x >> 24);
+}
+
+static uint32_t Rand_Next(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// 接收中断：失败时不前进，下次重写同一字节 (与真实中断丢字节不同，便于逐字节核对)
+static void *Producer(void *arg)
+{
+    uint32_t seq = seed;
+    uint64_t sent = 0;
+    uint8_t byte = Seq_Next(&seq);
+
+    (void)arg;
+    while (sent < totalBytes)
+    {
+        if (SPSC_Put(&ring, byte))
+        {
+            sent++;
+            byte = Seq_Next(&seq);
+        }
+        else
+        {
+            producerFails++;
+            sched_yield();  // 单核机器上让消费者先跑，否则整个时间片都在空转
+        }
+    }
+    __DMB();
+    producerDone = 1;
+    return NULL;
+}
+
+static void Fail(const char *what, uint64_t at)
+{
+    if (errors < 10)
+    {
+        printf("  !! %s at byte %llu\n", what, (unsigned long long)at);
+    }
+    errors++;
+}
+
+// 主循环：核对数据、计数和 high_water
+static void Consumer(void)
+{
+    uint32_t seq = seed;
+    uint32_t rnd = seed * 2654435761u + 1;
+    uint64_t received = 0;
+    uint16_t lastHigh = 0;
+    uint64_t modes[3] = {0, 0, 0};
+    uint8_t tmp[STRESS_SIZE_MAX];
+
+    while (received < totalBytes)
+    {
+        uint32_t r = Rand_Next(&rnd);
+        uint16_t high = ring.high_water;
+        uint16_t count = SPSC_Count(&ring);
+        uint16_t n = 0;
+        uint16_t i;
+
+        if (high < lastHigh || high > ringSize)
+        {
+            Fail("high_water went backwards or above size", received);
+        }
+        lastHigh = high;
+        if (count > ringSize)
+        {
+            Fail("SPSC_Count above size", received);
+        }
+
+        // 偶尔停顿，让生产者写满缓冲区
+        if ((r & 0x3FF) == 0)
+        {
+            usleep(50);
+            continue;
+        }
+
+        switch ((r >> 10) % 3)
+        {
+        case 0:
+        {
+            const uint8_t *data;
+            uint16_t avail = SPSC_Peek_Contig(&ring, &data);
+
+            // 只消费其中一部分，下次从中间接着读
+            n = avail ? (uint16_t)(1 + (r >> 12) % avail) : 0;
+            for (i = 0; i < n; i++)
+            {
+                if (data[i] != Seq_Next(&seq))
+                {
+                    Fail("SPSC_Peek_Contig data out of order", received + i);
+                }
+            }
+            SPSC_Consume(&ring, n);
+            break;
+        }
+        case 1:
+            n = SPSC_Read(&ring, tmp, (uint16_t)(1 + (r >> 12) % ringSize));
+            for (i = 0; i < n; i++)
+            {
+                if (tmp[i] != Seq_Next(&seq))
+                {
+                    Fail("SPSC_Read data out of order", received + i);
+                }
+            }
+            break;
+        default:
+            n = SPSC_Count(&ring);
+            if (n > 8)
+            {
+                n = 8;
+            }
+            for (i = 0; i < n; i++)
+            {
+                if (SPSC_Peek(&ring, i) != Seq_Next(&seq))
+                {
+                    Fail("SPSC_Peek data out of order", received + i);
+                }
+            }
+            SPSC_Consume(&ring, n);
+            break;
+        }
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        modes[(r >> 10) % 3] += n;
+        received += n;
+        if (errors >= 10)
+        {
+            break;
+        }
+    }
+
+    printf("read via Peek_Contig %llu, Read %llu, Peek %llu bytes\n",
+           (unsigned long long)modes[0], (unsigned long long)modes[1], (unsigned long long)modes[2]);
+}
+
+static void Usage(void)
+{
+    fprintf(stderr,
+            "usage: spsc_stress [-z size] [-n mbytes] [-s seed]\n"
+            "  -z  ring size, power of two 2..%d (default 64)\n"
+            "  -n  millions of bytes to pass through (default 20)\n"
+            "  -s  seed for data and consumer pattern (default 1)\n", STRESS_SIZE_MAX);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t producer;
+    unsigned long size = ringSize;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "z:n:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'z': size = strtoul(optarg, NULL, 0); break;
+        case 'n': totalBytes = strtoull(optarg, NULL, 0) * 1000000u; break;
+        case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: Usage();
+        }
+    }
+    if (size < 2 || size > STRESS_SIZE_MAX || (size & (size - 1)) != 0 || totalBytes == 0 || seed == 0)
+    {
+        Usage();
+    }
+    ringSize = (uint16_t)size;
+
+    SPSC_Init(&ring, stressBuf, ringSize);
+    // 计数从回绕点前开始，第一轮就跨过 0xFFFF -> 0
+    ring.head = 0xFFF0;
+    ring.tail = 0xFFF0;
+
+    if (pthread_create(&producer, NULL, Producer, NULL) != 0)
+    {
+        perror("pthread_create");
+        return 2;
+    }
+    Consumer();
+    if (errors > 0)
+    {
+        // 核对已失败，生产者可能在等空间：直接退出
+        printf("FAIL: %d errors\n", errors);
+        return 1;
+    }
+    pthread_join(producer, NULL);
+
+    printf("size %u, %llu bytes, 16-bit counter wrapped %llu times, dropped %lu, high_water %u\n",
+           ringSize, (unsigned long long)totalBytes, (unsigned long long)((totalBytes + 0xFFF0) >> 16),
+           (unsigned long)ring.dropped, ring.high_water);
+    if (ring.head != ring.tail || ring.head != (uint16_t)(0xFFF0 + totalBytes))
+    {
+        Fail("head/tail do not match bytes written", totalBytes);
+    }
+    if (ring.dropped != (uint32_t)producerFails)
+    {
+        Fail("dropped does not match failed SPSC_Put calls", totalBytes);
+    }
+    if (producerFails > 0 && ring.high_water != ringSize)
+    {
+        Fail("ring was full but high_water is below size", totalBytes);
+    }
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}